@@ -0,0 +1,109 @@
+#include "string_literal.hpp"
+#include <assert.h>
+
+#define ILLEGAL_HEX_DIGIT -1
+
+static int hexDigitToInt(char hex_digit){
+	if('0' <= hex_digit && hex_digit <= '9')
+		return hex_digit-'0';
+	if('A' <= hex_digit && hex_digit <= 'F')
+		return hex_digit-'A'+10;
+
+	//for some strage reson... uncapped a-f are not legal.
+	// if('a' <= hex_digit && hex_digit <= 'f')
+	// 	return hex_digit-'a'+10;
+	return ILLEGAL_HEX_DIGIT;
+}
+
+static char asciiLiteralToChar(char high_digit, char low_digit){
+	int result = hexDigitToInt(high_digit)*16 + hexDigitToInt(low_digit);
+	return (char)result;
+}
+
+static int isPrintableAsciiNum(int num){
+	return (0x20 <= num && num <= 0x7e)
+			|| num == 0x09 || num == 0x0a || num == 0x0d;
+}
+
+static int isInAsciiLegalRange(char c){
+	return 0x00 <= c && c <= 0x7f;
+}
+
+static int legalHexSequence(const char* seq){
+	if(seq[0] != 'x' && seq[1])
+		return 0;
+	if(seq[1] == '\0' || seq[2] == '\0')
+		return 0;
+	if(hexDigitToInt(seq[1]) == ILLEGAL_HEX_DIGIT 
+			|| hexDigitToInt(seq[2]) == ILLEGAL_HEX_DIGIT)
+		return 0;
+	//does the ascii value actually have to be printable?
+	return isInAsciiLegalRange(asciiLiteralToChar(seq[1], seq[2]));
+}
+
+void ignoreChar(char c, void* context){}
+
+StringLiteralStatus decodeStringLiteral(const char* src, int length, CharSink sink, void* context, char bad_escape[4]){
+	//make sure the string indeed starts with apostrophes:
+	assert(*src == '\"');
+	//if it does not end with apostrophes we throw an error
+	//, but undef escape seq has higher priority so we check for that.
+	
+	const char* string_end = src + length - 1;//-1 to ignore the apostrophes at the end of the string.
+	src++;//to ignore the parentheses at the start of the string.
+
+	while(src != string_end){
+		if(*src == '\n')
+			return STRING_UNCLOSED;
+		//do we need to create an error if the string includes an un-printable char?
+		if(*src != '\\'){
+			sink(*src, context);
+		} else{
+			src++;
+			if(src == string_end)
+				return STRING_UNCLOSED;
+			char escape_sequence[4] = "\0\0\0";
+			if(*src == 'x'){
+				escape_sequence[0] = 'x';
+				for(int i = 1; src+i <= string_end && src[i] != '\"' && i <= 2; i++)
+					escape_sequence[i] = src[i];
+				if(!legalHexSequence(escape_sequence)){
+					for(int i = 0; i < 4; i++)
+						bad_escape[i] = escape_sequence[i];
+					return STRING_UNDEFINED_ESCAPE;
+				}
+				char high_digit = *(++src), low_digit = *(++src);
+				sink(asciiLiteralToChar(high_digit, low_digit), context);
+			} else {
+				switch(*src){
+				case '\\':
+					sink('\\', context);
+					break;
+				case '\"':
+					sink('\"', context);
+					break;
+				case 'n':
+					sink('\n', context);
+					break;
+				case 'r':
+					sink('\r', context);
+					break;
+				case 't':
+					sink('\t', context);
+					break;
+				case '0':
+					sink('\0', context);
+					break;
+				default:
+					bad_escape[0] = *src;
+					bad_escape[1] = '\0';
+					return STRING_UNDEFINED_ESCAPE;
+				}
+			}
+		}
+		src++;
+	}
+	if(*string_end == '\n')
+		return STRING_UNCLOSED;
+	return STRING_OK;
+}
@@ -0,0 +1,18 @@
+#ifndef STRING_LITERAL_HPP_
+#define STRING_LITERAL_HPP_
+
+enum StringLiteralStatus{
+	STRING_OK,
+	STRING_UNCLOSED,
+	STRING_UNDEFINED_ESCAPE
+};
+
+//gets every decoded char of a string literal, along with the context that was given to decodeStringLiteral:
+typedef void (*CharSink)(char c, void* context);
+void ignoreChar(char c, void* context);
+
+//decodes the string literal of 'length' chars at 'src' (quotes included) into 'sink', one char at a time.
+//stops at the first error - for STRING_UNDEFINED_ESCAPE, 'bad_escape' gets the undefined sequence (without the backslash).
+StringLiteralStatus decodeStringLiteral(const char* src, int length, CharSink sink, void* context, char bad_escape[4]);
+
+#endif /* STRING_LITERAL_HPP_ */
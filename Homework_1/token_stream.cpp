@@ -0,0 +1,96 @@
+#include "token_stream.hpp"
+#include "string_literal.hpp"
+#include <algorithm>
+using namespace std;
+
+extern int token_offset;
+void scanBytes(const char* source, int length);
+void endScan();
+
+//the stream that gets the records of the lexer's error callbacks:
+static TokenStream* active_stream = nullptr;
+
+static void appendChar(char c, void* context){
+	static_cast<string*>(context)->push_back(c);
+}
+
+TokenStream::TokenStream(const char* source, int length){
+	active_stream = this;
+	scanBytes(source, length);
+}
+
+TokenStream::~TokenStream(){
+	endScan();
+	active_stream = nullptr;
+}
+
+void TokenStream::addRecord(int type){
+	PendingToken token = {.record = {
+		.type = type,
+		.line = yylineno,
+		.begin = token_offset,
+		.length = yyleng,
+		.value = nullptr,
+		.value_length = 0
+	}};
+	if(type == LEX_ERROR){
+		//an unclosed string ends with a newline, the line of the record is the one it starts at:
+		token.record.line -= count(yytext, yytext + yyleng, '\n');
+	} else if(type == STRING){
+		char bad_escape[4];
+		if(decodeStringLiteral(yytext, yyleng, appendChar, &token.value, bad_escape) != STRING_OK){
+			token.record.type = LEX_ERROR;
+			token.value.clear();
+		}
+		token.record.value_length = token.value.size();
+	}
+	pending.push_back(move(token));
+}
+
+void illegalChar(){
+	active_stream->addRecord(LEX_ERROR);
+}
+
+void unclosedString(){
+	active_stream->addRecord(LEX_ERROR);
+}
+
+//makes sure there is a pending record, returns false at the end of the source.
+bool TokenStream::scanNext(){
+	while(next_pending == pending.size()){
+		if(ended)
+			return false;
+		pending.clear();
+		next_pending = 0;
+		//the errors before the token are added by the callbacks while it is scanned:
+		int type = yylex();
+		if(type == 0)
+			ended = true;
+		else
+			addRecord(type);
+	}
+	return true;
+}
+
+bool TokenStream::next(TokenRecord& token){
+	return nextBatch(&token, 1) == 1;
+}
+
+int TokenStream::nextBatch(TokenRecord* tokens, int max_tokens){
+	values.clear();
+	int count = 0;
+	while(count < max_tokens && scanNext()){
+		PendingToken& token = pending[next_pending++];
+		tokens[count++] = token.record;
+		values += token.value;
+	}
+	//the values are pointed at only once they are all in place, as appending may move them:
+	int value_offset = 0;
+	for(int i = 0; i < count; i++){
+		if(tokens[i].type != STRING)
+			continue;
+		tokens[i].value = values.data() + value_offset;
+		value_offset += tokens[i].value_length;
+	}
+	return count;
+}
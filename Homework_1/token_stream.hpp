@@ -0,0 +1,54 @@
+#ifndef TOKEN_STREAM_HPP_
+#define TOKEN_STREAM_HPP_
+#include "tokens.hpp"
+#include <string>
+#include <vector>
+
+//the type of a record of text that is not a token (an illegal char, an unclosed string or a bad escape sequence):
+const int LEX_ERROR = -1;
+
+struct TokenRecord{
+	int type;//a tokentype, or LEX_ERROR.
+	int line;
+	//the span of the token in the source:
+	int begin;
+	int length;
+	//the decoded value of a STRING (not null terminated, may contain '\0'), nullptr for the other types.
+	//it is valid until the next call to the stream that returned it.
+	const char* value;
+	int value_length;
+};
+
+/**
+ * @brief reads the tokens of FanC source that is already in memory, without printing them.
+ * unlike hw1.out it does not stop at lexical errors - they are returned as LEX_ERROR records, and scanning goes on after them.
+ * the lexer is global, so only one TokenStream may exist at a time.
+ */
+class TokenStream{
+	//a record whose value is still kept in 'value':
+	struct PendingToken{
+		TokenRecord record;
+		std::string value;
+	};
+	std::vector<PendingToken> pending;
+	size_t next_pending = 0;
+	bool ended = false;
+	std::string values;
+
+	bool scanNext();
+	void addRecord(int type);
+	friend void illegalChar();
+	friend void unclosedString();
+public:
+	TokenStream(const char* source, int length);
+	~TokenStream();
+	TokenStream(const TokenStream&) = delete;
+	TokenStream& operator=(const TokenStream&) = delete;
+
+	//returns false at the end of the source.
+	bool next(TokenRecord& token);
+	//fills up to 'max_tokens' records of 'tokens', and returns how many were filled (0 at the end of the source).
+	int nextBatch(TokenRecord* tokens, int max_tokens);
+};
+
+#endif /* TOKEN_STREAM_HPP_ */
@@ -0,0 +1,55 @@
+# checks the TokenStream library (token_stream.hpp) through ../stream_dump.out (make stream_dump.out):
+# the tests of all.sh should be dumped just like hw1.out dumps them, when the tokens are read one by one and in batches,
+# and the tests of stream/ check the records that go on after lexical errors.
+# usage: ./stream.sh [path to stream_dump.out]   (default: ../stream_dump.out)
+EXE=${1:-'../stream_dump.out'}
+WORK_DIR=$(mktemp -d)
+trap "rm -rf $WORK_DIR" EXIT
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+if [ ! -f $EXE ]; then
+	printf "${RED}Error: executable: '${EXE}'  -  not found! ${NC}\n"
+	exit 1
+fi
+
+FAILED=0
+#runs the test with every batch size, the rest of the arguments are passed to stream_dump.out:
+check(){
+	TEST_NAME=$1
+	shift
+	for BATCH_SIZE in 0 1 2 3 64
+	do
+		$EXE $BATCH_SIZE "$@" < $TEST_NAME.in > $WORK_DIR/result
+		if ! diff $TEST_NAME.expected $WORK_DIR/result; then
+			printf "$TEST_NAME (batch size $BATCH_SIZE): ${RED} FAILURE ${NC}\n"
+			printf "\t${BLUE}< expected but not found${NC}\n"
+			printf "\t${BLUE}> found but not expected${NC}\n"
+			FAILED=1
+			return
+		fi
+	done
+	printf "$TEST_NAME: ${GREEN} SUCCESS ${NC}\n"
+}
+
+check pdf/example_test
+for i in {1..11}
+do
+	check old/t$i
+done
+for i in {1..2}
+do
+	check webc/t$i
+done
+for i in {1..16}
+do
+	check my/t$i
+done
+for TEST in $(ls stream/t*.in | sort -V)
+do
+	check ${TEST%.in} --continue
+done
+exit $FAILED
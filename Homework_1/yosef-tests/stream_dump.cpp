@@ -0,0 +1,100 @@
+#include "token_stream.hpp"
+#include "string_literal.hpp"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+using namespace std;
+
+//prints the tokens of stdin like hw1.out does, but reads them through a TokenStream (see stream.sh).
+//usage: stream_dump.out [batch size] [--continue]
+//	batch size: the records are read by nextBatch in batches of this size, and each batch is printed only once it is all read.
+//		0 (the default) reads them one by one with next.
+//	--continue: prints a line for every lexical error and goes on, instead of stopping at the first one like hw1.out.
+
+static const char* token_names[] = {"", "VOID", "INT", "BYTE", "B", "BOOL", "AND", "OR", "NOT", "TRUE", "FALSE",
+	"RETURN", "IF", "ELSE", "WHILE", "BREAK", "CONTINUE", "SC", "COMMA", "LPAREN", "RPAREN", "LBRACE", "RBRACE",
+	"ASSIGN", "RELOP", "BINOP", "COMMENT", "ID", "NUM", "STRING"};
+
+static void appendChar(char c, void* context){
+	static_cast<string*>(context)->push_back(c);
+}
+
+//the message hw1.out prints for the text of a LEX_ERROR record:
+static string errorMessage(const string& text){
+	if(text.size() == 1)
+		return "Error " + text;
+	//an unclosed string ends with the newline, anything else is a string that failed to decode:
+	char bad_escape[4];
+	string ignored;
+	if(text.back() != '\n' && decodeStringLiteral(text.data(), text.size(), appendChar, &ignored, bad_escape) == STRING_UNDEFINED_ESCAPE)
+		return string("Error undefined escape sequence ") + bad_escape;
+	return "Error unclosed string";
+}
+
+//prints the record the way hw1.out does, and returns false if the dump should stop after it.
+static bool printRecord(const string& source, const TokenRecord& token, bool keep_going){
+	assert(0 <= token.begin && token.length > 0 && token.begin + token.length <= (int)source.size());
+	string text = source.substr(token.begin, token.length);
+	if(token.type == LEX_ERROR){
+		if(!keep_going){
+			printf("%s\n", errorMessage(text).c_str());
+			return false;
+		}
+		printf("%d %s\n", token.line, errorMessage(text).c_str());
+		return true;
+	}
+	assert(1 <= token.type && token.type <= STRING);
+	printf("%d %s ", token.line, token_names[token.type]);
+	if(token.type == STRING){
+		//the value must still be the decoded text of its span:
+		string decoded;
+		char bad_escape[4];
+		StringLiteralStatus status = decodeStringLiteral(text.data(), text.size(), appendChar, &decoded, bad_escape);
+		assert(status == STRING_OK && token.value != nullptr && decoded == string(token.value, token.value_length));
+		fwrite(token.value, 1, token.value_length, stdout);
+	} else if(token.type == COMMENT){
+		assert(text.compare(0, 2, "//") == 0);
+		printf("//");
+	} else {
+		assert(token.value == nullptr);
+		fwrite(text.data(), 1, text.size(), stdout);
+	}
+	printf("\n");
+	return true;
+}
+
+int main(int argc, char* argv[]){
+	int batch_size = 0;
+	bool keep_going = false;
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--continue") == 0)
+			keep_going = true;
+		else
+			batch_size = atoi(argv[i]);
+	}
+	string source((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+	TokenStream stream(source.data(), source.size());
+
+	if(batch_size == 0){
+		TokenRecord token;
+		while(stream.next(token)){
+			if(!printRecord(source, token, keep_going))
+				return 0;
+		}
+		return 0;
+	}
+	vector<TokenRecord> batch(batch_size);
+	int count;
+	while((count = stream.nextBatch(batch.data(), batch_size)) > 0){
+		for(int i = 0; i < count; i++){
+			if(!printRecord(source, batch[i], keep_going))
+				return 0;
+		}
+	}
+	return 0;
+}
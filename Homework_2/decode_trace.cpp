@@ -0,0 +1,39 @@
+//turns the binary trace of 'hw2 --binary-trace' back into the text hw2 prints, or into the histogram of 'hw2 --count-rules' with --count-rules.
+//usage: decode_trace [--count-rules] < trace
+#include "trace.hpp"
+#include <cstdio>
+#include <cstring>
+
+//returns false at the end of the input:
+static bool readVarint(unsigned& value) {
+    value = 0;
+    for (int shift = 0; ; shift += 7) {
+        int byte = getchar_unlocked();
+        if (byte == EOF)
+            return false;
+        value |= (unsigned)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    trace::setMode(argc > 1 && strcmp(argv[1], "--count-rules") == 0 ? trace::COUNT : trace::TEXT);
+    unsigned ruleno;
+    while (readVarint(ruleno)) {
+        if (ruleno != 0) {
+            trace::productionRule(ruleno);
+            continue;
+        }
+        unsigned kind, lineno;
+        if (!readVarint(kind) || !readVarint(lineno))
+            break;
+        if (kind == trace::LEXICAL_ERROR)
+            trace::errorLex(lineno);
+        else
+            trace::errorSyn(lineno);
+        return 0;
+    }
+    trace::finish();
+    return 0;
+}
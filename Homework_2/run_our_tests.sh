@@ -15,4 +15,29 @@ done
 ./hw2 < t1.in >& t1.myout
 ./hw2 < t2.in >& t2.myout
 diff t1.out t1.myout
-diff t2.out t2.myout
\ No newline at end of file
+diff t2.out t2.myout
+
+# Check the traces: 'hw2 --binary-trace | decode_trace' should print exactly what hw2 prints, including the error that ends
+# the parsing (written as a 0, then its kind and line), and 'hw2 --count-rules' should count the reductions of that text
+TRACES=$(mktemp -d)
+trap "rm -rf $TRACES" EXIT
+
+# prints the histogram of the reductions in the text trace $1 like --count-rules does, then its error (if any)
+count_rules(){
+  grep -E '^[0-9]+: ' $1 | sort -s -t: -k1,1n | uniq -c | sort -s -k1,1nr | sed -E 's/^ +//' \
+    | awk '{n = index($0, " "); printf "%10d  %s\n", substr($0, 1, n - 1), substr($0, n + 1)}'
+  grep -vE '^[0-9]+: ' $1
+}
+
+for f in itay-tests/t*.in yosef-tests/*/t*.in
+do
+  echo "Checking the traces of "$f
+  ./hw2 < $f > $TRACES/text
+  ./hw2 --binary-trace < $f | ./decode_trace > $TRACES/decoded
+  diff $TRACES/text $TRACES/decoded
+  count_rules $TRACES/text > $TRACES/counted
+  ./hw2 --count-rules < $f > $TRACES/count
+  diff $TRACES/counted $TRACES/count
+  ./hw2 --binary-trace < $f | ./decode_trace --count-rules > $TRACES/count
+  diff $TRACES/counted $TRACES/count
+done
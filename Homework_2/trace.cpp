@@ -0,0 +1,93 @@
+#include "trace.hpp"
+#include "output.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#define NUM_RULES 48
+#define BUFFER_SIZE (1 << 16)
+
+static trace::Mode mode = trace::TEXT;
+static unsigned char buffer[BUFFER_SIZE];
+static int buffer_length = 0;
+static long long rule_counts[NUM_RULES + 1] = {0};
+
+static void flushBuffer() {
+    fwrite(buffer, 1, buffer_length, stdout);
+    buffer_length = 0;
+}
+
+//LEB128 - 7 bits per byte, the high bit marks that more bytes follow:
+static void writeVarint(unsigned value) {
+    //a varint of an unsigned is at most 5 bytes:
+    if (buffer_length + 5 > BUFFER_SIZE)
+        flushBuffer();
+    while (value >= 0x80) {
+        buffer[buffer_length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[buffer_length++] = (unsigned char)value;
+}
+
+static void printHistogram() {
+    std::vector<int> rules;
+    for (int ruleno = 1; ruleno <= NUM_RULES; ++ruleno)
+        if (rule_counts[ruleno] > 0)
+            rules.push_back(ruleno);
+    std::stable_sort(rules.begin(), rules.end(), [](int first, int second) {
+        return rule_counts[first] > rule_counts[second];
+    });
+    for (int ruleno : rules)
+        printf("%10lld  %d: %s\n", rule_counts[ruleno], ruleno, output::rules[ruleno - 1].c_str());
+    fflush(stdout);
+}
+
+//the error ends the parsing, so the trace before it is written first:
+static void error(trace::ErrorKind kind, int lineno) {
+    if (mode == trace::BINARY) {
+        writeVarint(0);
+        writeVarint(kind);
+        writeVarint(lineno);
+        flushBuffer();
+        return;
+    }
+    trace::finish();
+    if (kind == trace::LEXICAL_ERROR)
+        output::errorLex(lineno);
+    else
+        output::errorSyn(lineno);
+}
+
+void trace::setMode(Mode new_mode) {
+    mode = new_mode;
+}
+
+void trace::productionRule(int ruleno) {
+    switch (mode) {
+    case TEXT:
+        output::printProductionRule(ruleno);
+        break;
+    case BINARY:
+        writeVarint(ruleno);
+        break;
+    case COUNT:
+        ++rule_counts[ruleno];
+        break;
+    }
+}
+
+void trace::errorLex(int lineno) {
+    error(LEXICAL_ERROR, lineno);
+}
+
+void trace::errorSyn(int lineno) {
+    error(SYNTAX_ERROR, lineno);
+}
+
+void trace::finish() {
+    if (mode == BINARY)
+        flushBuffer();
+    else if (mode == COUNT)
+        printHistogram();
+}
@@ -0,0 +1,25 @@
+#ifndef _TRACE_HPP_
+#define _TRACE_HPP_
+
+//where the reductions of the parser (and the errors that end it) are written to.
+namespace trace {
+    enum Mode {
+        TEXT,   //a line per reduction, by output::printProductionRule.
+        BINARY, //a varint per reduction, decoded back to TEXT by decode_trace.
+        COUNT   //only a histogram of the reductions, when the parsing ends.
+    };
+    //the binary trace marks an error with a 0 (which is never a rule number), followed by its kind and line number:
+    enum ErrorKind {
+        LEXICAL_ERROR = 1,
+        SYNTAX_ERROR = 2
+    };
+
+    void setMode(Mode mode);
+    void productionRule(int ruleno);
+    void errorLex(int lineno);
+    void errorSyn(int lineno);
+    //writes whatever is still buffered (or the histogram), must be called once the parsing ends.
+    void finish();
+};
+
+#endif
@@ -0,0 +1,356 @@
+#include "SemanticIndex.hpp"
+#include "Symtab.hpp"
+#include "hw3_output.hpp"
+#include "assert.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+using namespace std;
+
+extern SimpleSymtab symtab;
+
+static bool analyzing = false;
+
+void analysisFailed(int exit_code){
+	if(analyzing)
+		throw AnalysisError();
+	exit(exit_code);
+}
+
+static string functionTypeString(const FunctionType& type){
+	vector<string> str_arg_types = ExpTypeStringVector(type.getParameterTypes(), true);
+	return output::makeFunctionType(ExpTypeString(type.return_type, true), str_arg_types);
+}
+
+int FunctionIndex::declare(const string& id, DeclKind kind, const string& type, bool is_const, int offset, int line){
+	int decl = decls.size();
+	decls.push_back({.id = id, .kind = kind, .type = type, .is_const = is_const, .offset = offset, .line = line
+		, .scope = kind == FUNC_DECL ? NO_SCOPE : current_scope});
+	reference(id, line, decl);
+	return decl;
+}
+
+void FunctionIndex::reference(const string& id, int line, int decl){
+	refs.push_back({.id = id, .line = line, .decl = decl});
+}
+
+void FunctionIndex::openScope(int line){
+	scopes.push_back({.first_line = line, .last_line = line, .parent = current_scope});
+	current_scope = scopes.size() - 1;
+}
+
+void FunctionIndex::closeScope(int line){
+	assert(current_scope != NO_SCOPE);
+	scopes[current_scope].last_line = line;
+	current_scope = scopes[current_scope].parent;
+}
+
+void FunctionIndex::setError(const string& printed_error){
+	failed = true;
+	error = printed_error.substr(0, printed_error.find('\n'));
+	//every error of a function starts with "line <n>:":
+	if(error.compare(0, 5, "line ") == 0){
+		size_t colon = error.find(':');
+		error_line = atoi(error.c_str() + 5);
+		error = error.substr(colon + 1);
+	}
+	//the scopes left open end at the error, so what was written before it (e.g of an unfinished function) can be queried:
+	while(current_scope != NO_SCOPE)
+		closeScope(error_line);
+}
+
+bool FunctionIndex::dependsOn(const unordered_set<string>& ids) const{
+	if(failed)
+		return true;
+	for(const IndexedRef& ref : refs){
+		if(ids.count(ref.id) != 0)
+			return true;
+	}
+	return false;
+}
+
+struct SourceChunk{
+	size_t begin;
+	size_t end;
+	int first_line;
+};
+
+//splits 'source' after the closing brace of every function, braces in comments and strings are skipped:
+static vector<SourceChunk> splitFunctions(const string& source){
+	vector<SourceChunk> chunks;
+	size_t begin = 0;
+	int line = 1;
+	int first_line = 1;
+	int depth = 0;
+	for(size_t i = 0; i < source.size(); ++i){
+		char c = source[i];
+		if(c == '\n'){
+			++line;
+		}else if(c == '/' && i + 1 < source.size() && source[i + 1] == '/'){
+			//stops before the new line, so it is counted:
+			while(i + 1 < source.size() && source[i + 1] != '\n')
+				++i;
+		}else if(c == '"'){
+			size_t j = i + 1;
+			while(j < source.size() && source[j] != '"' && source[j] != '\n')
+				j += (source[j] == '\\' && j + 1 < source.size() && source[j + 1] != '\n') ? 2 : 1;
+			i = (j < source.size() && source[j] == '"') ? j : j - 1;
+		}else if(c == '{'){
+			++depth;
+		}else if(c == '}' && depth > 0 && --depth == 0){
+			chunks.push_back({.begin = begin, .end = i + 1, .first_line = first_line});
+			begin = i + 1;
+			first_line = line;
+		}
+	}
+	//a function that is still being written is analyzed too (and fails):
+	if(source.find_first_not_of(" \t\r\n", begin) != string::npos)
+		chunks.push_back({.begin = begin, .end = source.size(), .first_line = first_line});
+	return chunks;
+}
+
+SemanticIndex::SemanticIndex(){
+	resetAnalysis();
+	for(const string& id : {"print", "printi"})
+		library_funcs.push_back({.id = id, .kind = FUNC_DECL, .type = functionTypeString(symtab.getFunctionType(id))
+			, .is_const = false, .offset = 0, .line = 0, .scope = NO_SCOPE});
+}
+
+void SemanticIndex::analyze(FunctionIndex& function){
+	//the errors are printed to the standard output, they are caught and kept in the function instead:
+	stringstream printed_error;
+	streambuf* out = cout.rdbuf(printed_error.rdbuf());
+	symtab.recordInto(&function);
+	analyzing = true;
+	try{
+		parseText(function.text);
+	}catch(const AnalysisError&){
+		symtab.abandonFunc();
+		function.setError(printed_error.str());
+	}
+	analyzing = false;
+	symtab.recordInto(nullptr);
+	cout.rdbuf(out);
+
+	stable_sort(function.refs.begin(), function.refs.end()
+		, [](const IndexedRef& first, const IndexedRef& second){return first.line < second.line;});
+	if(function.declared())
+		function.type = symtab.getFunctionType(function.decls.front().id);
+}
+
+int SemanticIndex::update(const string& source){
+	vector<SourceChunk> chunks = splitFunctions(source);
+	vector<FunctionIndex> old_functions;
+	old_functions.swap(functions);
+	auto sameText = [&](const SourceChunk& chunk, const FunctionIndex& function){
+		return source.compare(chunk.begin, chunk.end - chunk.begin, function.text) == 0;
+	};
+
+	//the functions in [prefix, changed_end) are new or changed, the ones around them are kept:
+	size_t prefix = 0;
+	while(prefix < chunks.size() && prefix < old_functions.size() && sameText(chunks[prefix], old_functions[prefix]))
+		++prefix;
+	size_t suffix = 0;
+	while(suffix < chunks.size() - prefix && suffix < old_functions.size() - prefix
+			&& sameText(chunks[chunks.size() - 1 - suffix], old_functions[old_functions.size() - 1 - suffix]))
+		++suffix;
+	const size_t changed_end = chunks.size() - suffix;
+	const size_t old_changed_end = old_functions.size() - suffix;
+
+	//the headers of the functions that were replaced, a header that is not declared again has changed:
+	unordered_map<string, string> old_headers;
+	for(size_t i = prefix; i < old_changed_end; ++i){
+		if(old_functions[i].declared())
+			old_headers[old_functions[i].decls.front().id] = old_functions[i].decls.front().type;
+	}
+	unordered_set<string> changed_ids;
+
+	resetAnalysis();
+	int analyzed = 0;
+	functions.reserve(chunks.size());
+	for(size_t i = 0; i < chunks.size(); ++i){
+		const SourceChunk& chunk = chunks[i];
+		if(i == changed_end){
+			for(auto& header : old_headers)
+				changed_ids.insert(header.first);
+		}
+		bool changed = prefix <= i && i < changed_end;
+		FunctionIndex* old_function = changed ? nullptr
+			: &old_functions[i < prefix ? i : i - changed_end + old_changed_end];
+		if(old_function && (changed_ids.empty() || !old_function->dependsOn(changed_ids))){
+			functions.push_back(std::move(*old_function));
+			functions.back().first_line = chunk.first_line;
+			if(functions.back().declared())
+				symtab.importFunc(functions.back().decls.front().id, functions.back().type);
+			continue;
+		}
+
+		FunctionIndex function(source.substr(chunk.begin, chunk.end - chunk.begin), chunk.first_line);
+		analyze(function);
+		++analyzed;
+		const IndexedDecl* header = function.declared() ? &function.decls.front() : nullptr;
+		if(changed){
+			auto old_header = header ? old_headers.find(header->id) : old_headers.end();
+			if(old_header != old_headers.end() && old_header->second == header->type)
+				old_headers.erase(old_header);
+			else if(header)
+				changed_ids.insert(header->id);
+		}else{
+			const IndexedDecl* old_header = old_function->declared() ? &old_function->decls.front() : nullptr;
+			if(old_header && !(header && header->id == old_header->id && header->type == old_header->type))
+				changed_ids.insert(old_header->id);
+			if(header && !(old_header && header->id == old_header->id && header->type == old_header->type))
+				changed_ids.insert(header->id);
+		}
+		functions.push_back(std::move(function));
+	}
+
+	function_ids.clear();
+	for(size_t i = 0; i < functions.size(); ++i){
+		if(functions[i].declared())
+			function_ids[functions[i].decls.front().id] = i;
+	}
+	return analyzed;
+}
+
+int SemanticIndex::functionAt(int line) const{
+	auto after = upper_bound(functions.begin(), functions.end(), line
+		, [](int line, const FunctionIndex& function){return line < function.first_line;});
+	return int(after - functions.begin()) - 1;
+}
+
+bool SemanticIndex::findFunction(const string& id, SymbolInfo& result) const{
+	auto found = function_ids.find(id);
+	if(found != function_ids.end()){
+		const FunctionIndex& function = functions[found->second];
+		result = {.decl = &function.decls.front(), .line = function.absoluteLine(function.decls.front().line)};
+		return true;
+	}
+	for(const IndexedDecl& decl : library_funcs){
+		if(decl.id == id){
+			result = {.decl = &decl, .line = 0};
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SemanticIndex::findDefinition(int line, const string& id, SymbolInfo& result) const{
+	//a function starts at the line its previous function ended at, so that line might belong to either of them:
+	for(int i = functionAt(line); i >= 0 && functions[i].absoluteLine(1) <= line; --i){
+		const FunctionIndex& function = functions[i];
+		int relative_line = line - function.first_line + 1;
+		auto ref = lower_bound(function.refs.begin(), function.refs.end(), relative_line
+			, [](const IndexedRef& ref, int line){return ref.line < line;});
+		for(; ref != function.refs.end() && ref->line == relative_line; ++ref){
+			if(ref->id != id)
+				continue;
+			if(ref->decl == NO_DECL)
+				return findFunction(id, result);
+			const IndexedDecl& decl = function.decls[ref->decl];
+			result = {.decl = &decl, .line = function.absoluteLine(decl.line)};
+			return true;
+		}
+		if(relative_line != 1)
+			break;
+	}
+	return false;
+}
+
+vector<SymbolInfo> SemanticIndex::visibleAt(int line) const{
+	vector<SymbolInfo> result;
+	int function_index = functionAt(line);
+	if(function_index >= 0){
+		const FunctionIndex& function = functions[function_index];
+		int relative_line = line - function.first_line + 1;
+		//the scopes are in the order they were opened, so the last one that contains the line is the innermost:
+		int scope = NO_SCOPE;
+		for(int i = function.scopes.size() - 1; i >= 0 && scope == NO_SCOPE; --i){
+			if(function.scopes[i].first_line <= relative_line && relative_line <= function.scopes[i].last_line)
+				scope = i;
+		}
+		for(; scope != NO_SCOPE; scope = function.scopes[scope].parent){
+			for(auto decl = function.decls.rbegin(); decl != function.decls.rend(); ++decl){
+				if(decl->scope == scope && decl->line <= relative_line)
+					result.push_back({.decl = &*decl, .line = function.absoluteLine(decl->line)});
+			}
+		}
+	}
+	for(int i = function_index; i >= 0; --i){
+		if(functions[i].declared())
+			result.push_back({.decl = &functions[i].decls.front(), .line = functions[i].absoluteLine(functions[i].decls.front().line)});
+	}
+	for(const IndexedDecl& decl : library_funcs)
+		result.push_back({.decl = &decl, .line = 0});
+	return result;
+}
+
+vector<string> SemanticIndex::errors() const{
+	vector<string> result;
+	for(const FunctionIndex& function : functions){
+		if(function.failed)
+			result.push_back("line " + to_string(function.absoluteLine(function.error_line)) + ":" + function.error);
+	}
+	auto main_func = function_ids.find("main");
+	if(main_func == function_ids.end() || functions[main_func->second].decls.front().type != "()->VOID"){
+		stringstream printed_error;
+		streambuf* out = cout.rdbuf(printed_error.rdbuf());
+		output::errorMainMissing();
+		cout.rdbuf(out);
+		result.push_back(printed_error.str().substr(0, printed_error.str().find('\n')));
+	}
+	return result;
+}
+
+static void printSymbol(const SymbolInfo& symbol){
+	cout << "line " << symbol.line << ": ";
+	output::printID(symbol.decl->id, symbol.decl->offset, symbol.decl->type);
+}
+
+/**
+ * reads one command per line from the standard input:
+ * 		update				- reads the file again, and prints how many functions were analyzed.
+ * 		def <line> <id>		- prints where 'id' at 'line' is declared, its type and offset.
+ * 		type <line> <id>	- prints the type of 'id' at 'line'.
+ * 		visible <line>		- prints every declaration that can be used at 'line'.
+ * 		errors				- prints the first error of every function.
+ * an identifier that can not be found prints "none".
+ */
+int serveIndex(const char* path){
+	SemanticIndex index;
+	string command;
+	while(cin >> command){
+		if(command == "update"){
+			ifstream file(path);
+			stringstream source;
+			source << file.rdbuf();
+			int analyzed = index.update(source.str());
+			cout << "analyzed " << analyzed << " of " << index.functionCount() << " functions" << endl;
+		}else if(command == "def" || command == "type"){
+			int line;
+			string id;
+			cin >> line >> id;
+			SymbolInfo symbol;
+			if(!index.findDefinition(line, id, symbol))
+				cout << "none" << endl;
+			else if(command == "def")
+				printSymbol(symbol);
+			else
+				cout << symbol.decl->type << endl;
+		}else if(command == "visible"){
+			int line;
+			cin >> line;
+			for(const SymbolInfo& symbol : index.visibleAt(line))
+				printSymbol(symbol);
+		}else if(command == "errors"){
+			for(const string& error : index.errors())
+				cout << error << endl;
+		}else{
+			cout << "unknown command " << command << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
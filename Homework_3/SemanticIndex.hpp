@@ -0,0 +1,148 @@
+#ifndef SEMANTIC_INDEX_H
+#define SEMANTIC_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "AuxTypes.hpp"
+
+//thrown instead of exiting when an error is found while a SemanticIndex analyzes a function:
+struct AnalysisError{};
+
+/**
+ * @brief called after the first error of the analysis was printed.
+ * 		exits with 'exit_code' like the analyzer always did, unless a SemanticIndex is analyzing, then it throws AnalysisError.
+ */
+[[noreturn]] void analysisFailed(int exit_code = 1);
+
+//implemented by the lexer, makes it read 'text' (from line 1) instead of the standard input:
+void beginScanning(const std::string& text);
+void endScanning();
+//implemented by the parser:
+void resetAnalysis();
+void parseText(const std::string& text);
+
+enum DeclKind{
+	FUNC_DECL,
+	PARAM_DECL,
+	VAR_DECL
+};
+
+const int NO_DECL = -1;
+const int NO_SCOPE = -1;
+
+/**
+ * the entries of a function use lines relative to the first line of its text (which is line 1),
+ * so a function that only moved keeps its entries, and just gets a new 'first_line'.
+ */
+struct IndexedDecl{
+	std::string id;
+	DeclKind kind;
+	std::string type;//formatted like in the scope dump, e.g "INT" or "(INT,BYTE)->VOID".
+	bool is_const;
+	int offset;
+	int line;
+	int scope;//the function itself is in the global scope, NO_SCOPE.
+};
+
+struct IndexedRef{
+	std::string id;
+	int line;
+	//an index into the decls of the same function, or NO_DECL for a function, which is found by its id.
+	//every declaration is also a reference to itself.
+	int decl;
+};
+
+struct IndexedScope{
+	int first_line;
+	int last_line;
+	int parent;
+};
+
+/**
+ * @brief everything the analysis of a single function found, the symtab records into it while the function is parsed.
+ */
+struct FunctionIndex{
+	FunctionIndex(const std::string& text, int first_line)
+		:text(text), first_line(first_line){}
+
+	int declare(const std::string& id, DeclKind kind, const std::string& type, bool is_const, int offset, int line);
+	void reference(const std::string& id, int line, int decl);
+	void openScope(int line);
+	void closeScope(int line);
+	//keeps the first line of the error printed to 'printed_error', without its line number:
+	void setError(const std::string& printed_error);
+
+	bool declared() const{
+		return !decls.empty();
+	}
+	int absoluteLine(int line) const{
+		return first_line + line - 1;
+	}
+	//whether analyzing the function again might give different results if the functions in 'ids' were declared differently:
+	bool dependsOn(const std::unordered_set<std::string>& ids) const;
+
+	std::string text;
+	int first_line;
+	FunctionType type;//valid only if the function is declared.
+	std::vector<IndexedDecl> decls;//the function itself is at the front.
+	std::vector<IndexedRef> refs;//sorted by line once the analysis is done.
+	std::vector<IndexedScope> scopes;//the scope of the parameters is at the front.
+	int current_scope = NO_SCOPE;
+	bool failed = false;
+	int error_line = 0;
+	std::string error;
+};
+
+//a declaration, valid until the next update of the index:
+struct SymbolInfo{
+	const IndexedDecl* decl;
+	int line;
+};
+
+/**
+ * @brief a queryable index of the declarations, references and scopes of a file, for editor tooling.
+ * 		the file is split at the closing braces of its functions, and every function is analyzed on its own,
+ * 		so an update only analyzes the functions whose text changed.
+ * 		unlike the analyzer, it does not stop at the first error; each function keeps its first error and
+ * 		everything that was indexed before it.
+ */
+class SemanticIndex{
+public:
+	SemanticIndex();
+	/**
+	 * @brief brings the index up to date with 'source', the whole text of the file.
+	 * 		the functions after a changed function are analyzed again only if they use a function whose header changed
+	 * 		(or if they have an error).
+	 * @return int - the number of functions that were analyzed.
+	 */
+	int update(const std::string& source);
+
+	/**
+	 * @brief finds the declaration that 'id' at 'line' refers to, or that is declared there.
+	 * @return bool - false if 'id' is not referred to at 'line'.
+	 */
+	bool findDefinition(int line, const std::string& id, SymbolInfo& result) const;
+	//the declarations that can be used at 'line', innermost scope first. the library functions are at line 0.
+	std::vector<SymbolInfo> visibleAt(int line) const;
+	//the first error of every function, in order, printed like the analyzer prints them:
+	std::vector<std::string> errors() const;
+	int functionCount() const{
+		return functions.size();
+	}
+private:
+	void analyze(FunctionIndex& function);
+	bool findFunction(const std::string& id, SymbolInfo& result) const;
+	//the index of the function that 'line' is in, or -1:
+	int functionAt(int line) const;
+
+	std::vector<FunctionIndex> functions;
+	std::unordered_map<std::string, int> function_ids;
+	std::vector<IndexedDecl> library_funcs;
+};
+
+//answers queries about the file at 'path' from the standard input, see the definition for the commands:
+int serveIndex(const char* path);
+
+#endif
@@ -1,18 +1,25 @@
 #include "Symtab.hpp"
 #include "assert.h"
 #include "hw3_output.hpp"
+#include "SemanticIndex.hpp"
 #include <iostream>
 using namespace std;
 
+extern int yylineno;
+
 const std::string SimpleSymtab::NO_CURRENTLY_PARSED_FUNC = "";
 
 void SimpleSymtab::pushScope(){
 	scope_ids_stack.push_back(vector<string>());
+	if(recording)
+		recording->openScope(yylineno);
 }
 
 void SimpleSymtab::popScope(bool print_end_scope){
-	if(print_end_scope)
+	if(print_end_scope && !recording)
 		output::endScope();
+	if(recording)
+		recording->closeScope(yylineno);
 	
 	auto& top_scope = scope_ids_stack.back();
 	int i = 0;
@@ -24,7 +31,8 @@ void SimpleSymtab::popScope(bool print_end_scope){
 		--curr_offset;
 		//int ordered_offset = curr_offset - (top_scope.size() )- 1;
 		int ordered_offset = 2*initial_offset - scope_size - curr_offset - 1; 
-		output::printID(id, ordered_offset, ExpTypeString(getVariableType(id), true));
+		if(!recording)
+			output::printID(id, ordered_offset, ExpTypeString(getVariableType(id), true));
 		variable_decls.erase(id);
 		++i;
 	}
@@ -34,7 +42,8 @@ void SimpleSymtab::popScope(bool print_end_scope){
 
 void SimpleSymtab::declareVar(const string& id, ExpType type, bool is_const){
 	assert(declarableValidId(id));
-		variable_decls[id] = {.type = type, .is_const = is_const, .offset = curr_offset};
+	int index_decl = recording ? recording->declare(id, VAR_DECL, ExpTypeString(type, true), is_const, curr_offset, yylineno) : NO_DECL;
+	variable_decls[id] = {.type = type, .is_const = is_const, .offset = curr_offset, .index_decl = index_decl};
 	scope_ids_stack.back().push_back(id);
 	++curr_offset;
 }
@@ -45,23 +54,37 @@ void SimpleSymtab::declareFunc(const string& func_id, ExpType type, vector<Param
 	assert(declarableValidId(func_id));
 	assert(func_scope.size() == 0);
 	function_decls[func_id] = FunctionType(type, params);
+	if(recording){
+		vector<string> str_arg_types = ExpTypeStringVector(function_decls[func_id].getParameterTypes(), true);
+		string func_type_str = output::makeFunctionType(ExpTypeString(type, true), str_arg_types);
+		recording->declare(func_id, FUNC_DECL, func_type_str, false, 0, yylineno);
+	}
+	//the parameters are recorded in the scope of the function:
+	pushScope();
 
 	int param_offset = 0;
 	for(auto it = params->rbegin(); it != params->rend(); ++it){
 		Parameter& p = *it;
 		assert(declarableValidId(p.id));
 		--param_offset;
-		variable_decls[p.id] = {.type = p.type, .is_const = p.is_const, .offset = param_offset};
+		int index_decl = recording ? recording->declare(p.id, PARAM_DECL, ExpTypeString(p.type, true), p.is_const, param_offset, p.line_of_origin) : NO_DECL;
+		variable_decls[p.id] = {.type = p.type, .is_const = p.is_const, .offset = param_offset, .index_decl = index_decl};
 		func_scope.push_back(p.id);
 	}
 	func_ids_stack.push_back(func_id);
-	pushScope();
+}
+
+void SimpleSymtab::importFunc(const string& func_id, const FunctionType& type){
+	assert(declarableValidId(func_id));
+	function_decls[func_id] = type;
+	func_ids_stack.push_back(func_id);
 }
 
 void SimpleSymtab::finishFunc(bool print_decls){
 	assert(currently_parsed_func != NO_CURRENTLY_PARSED_FUNC);
 	currently_parsed_func = NO_CURRENTLY_PARSED_FUNC;
 
+	print_decls = print_decls && !recording;
 	if(print_decls)
 		output::endScope();
 	int param_offset = -1;
@@ -77,6 +100,24 @@ void SimpleSymtab::finishFunc(bool print_decls){
 	popScope(false);
 }
 
+void SimpleSymtab::abandonFunc(){
+	currently_parsed_func = NO_CURRENTLY_PARSED_FUNC;
+	variable_decls.clear();
+	scope_ids_stack.clear();
+	func_scope.clear();
+	curr_offset = 0;
+}
+
+void SimpleSymtab::recordInto(FunctionIndex* function_index){
+	recording = function_index;
+}
+
+void SimpleSymtab::recordReference(const string& id){
+	if(!recording)
+		return;
+	recording->reference(id, yylineno, containsVar(id) ? variable_decls.at(id).index_decl : NO_DECL);
+}
+
 bool SimpleSymtab::containsVar(const string& id) const{
 	return variable_decls.count(id) == 1;
 }
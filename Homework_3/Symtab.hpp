@@ -7,6 +7,7 @@
 #include <utility>
 #include "AuxTypes.hpp"
 
+struct FunctionIndex;
 
 class SimpleSymtab{
 public:
@@ -15,8 +16,12 @@ public:
 
 	void declareVar(const std::string& id, ExpType type, bool is_const);
 	void declareFunc(const std::string& id, ExpType return_type, std::vector<Parameter>* params);
+	//declares a function that was analyzed before, without opening its scope:
+	void importFunc(const std::string& id, const FunctionType& type);
 	//void declareLibFunc(const std::string& func_id, ExpType type, std::vector<Parameter>* params);
 	void finishFunc(bool print_decls = true);
+	//drops the scopes of the function that is currently parsed, after an error was found in it:
+	void abandonFunc();
 	bool declarableValidId(const std::string& id) const;
 	bool containsVar(const std::string& id) const;
 	bool rvalValidId(const std::string& id) const;
@@ -31,6 +36,13 @@ public:
 	FunctionType& getFunctionType(const std::string& id);
 	FunctionType& getCurrentlyParsedFuncType();
 
+	/**
+	 * @brief while 'function_index' is not null, every declaration, scope and reference (see recordReference)
+	 * 		is recorded into it, and the scopes are not printed.
+	 */
+	void recordInto(FunctionIndex* function_index);
+	void recordReference(const std::string& id);
+
 	void printFuncDecls();
 	//for debugging:
 	void printFuncScope() const;
@@ -39,6 +51,7 @@ private:
 		ExpType type;
 		bool is_const;
 		int offset;
+		int index_decl;//the index of the declaration in 'recording', if there is one.
 	};
 	std::unordered_map<std::string, SymInfo> variable_decls;
 	//in each scope here, each id is a variable defined in the last scope:
@@ -48,6 +61,7 @@ private:
 	std::vector<std::string> func_scope;//each id here is a function parameter
 	int curr_offset = 0;//at any stable point, this will point to the first offset that is avaliable.
 	std::string currently_parsed_func = NO_CURRENTLY_PARSED_FUNC;
+	FunctionIndex* recording = nullptr;
 	static const std::string NO_CURRENTLY_PARSED_FUNC;
 };
 
@@ -0,0 +1,73 @@
+# runs scripted sessions of 'hw3 --index' and compares their output to the expected one.
+# every line of index/tN.session is sent to the server, except that 'update <file>' first replaces the indexed file
+# with index/<file>, so a session can follow the edits of a file.
+# usage: ./check_index.sh [min test] [max test] [path to hw3]   (default: 1 5 ../hw3)
+TESTS_DIR='index'
+MIN_TEST=${1:-1}
+MAX_TEST=${2:-5}
+EXE=${3:-'../hw3'}
+WORK_DIR=$(mktemp -d)
+trap "rm -rf $WORK_DIR" EXIT
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+if [ ! -f $EXE ]; then
+	printf "${RED}Error: executable: '${EXE}'  -  not found! ${NC}\n"
+	exit 1
+fi
+
+# waits until the server printed the result of $1 updates, or exited:
+function wait_for_updates () {
+	while [ $(grep -c "^analyzed" $TEST.res) -lt $1 ] && kill -0 $SERVER 2> /dev/null
+	do
+		sleep 0.01
+	done
+}
+
+function check_session () {
+	TEST=$TESTS_DIR/t$1
+	if [ ! -f $TEST.session ]; then
+		printf "$TEST.session: ${BLUE} NOT FOUND ${NC}\n"
+		return 0
+	fi
+	SOURCE=$WORK_DIR/source.fanc
+	: > $SOURCE
+	rm -f $WORK_DIR/commands
+	mkfifo $WORK_DIR/commands
+	$EXE --index $SOURCE < $WORK_DIR/commands > $TEST.res &
+	SERVER=$!
+	exec 3> $WORK_DIR/commands
+	UPDATES=0
+	while read -r COMMAND ARGS
+	do
+		if [ "$COMMAND" == "update" ]; then
+			# the file is only read by an update, so it can be replaced once the previous one is done:
+			wait_for_updates $UPDATES
+			cp $TESTS_DIR/$ARGS $SOURCE
+			UPDATES=$((UPDATES + 1))
+			echo "update" >&3
+		else
+			echo "$COMMAND $ARGS" >&3
+		fi
+	done < $TEST.session
+	exec 3>&-
+	wait $SERVER
+
+	diff $TEST.exp $TEST.res
+	if [ $? -eq 0 ]; then
+		printf "$TEST: ${GREEN} SUCCESS ${NC}\n"
+	else
+		printf "$TEST: ${RED} FAILURE ${NC}\n"
+		printf "\t${BLUE}< expected but not found${NC}\n"
+		printf "\t${BLUE}> found but not expected${NC}\n"
+		return 1
+	fi
+}
+
+for i in $(seq $MIN_TEST $MAX_TEST)
+do
+	check_session $i || exit 1
+done
@@ -0,0 +1,36 @@
+#include "Ast.hpp"
+#include "assert.h"
+
+AstIndex AstArena::add(AstKind kind, int line, uint8_t op, AstIndex a, AstIndex b, AstIndex c){
+	nodes.push_back({.kind = kind, .op = op, .line = line, .a = a, .b = b, .c = c, .next = AST_NONE});
+	return nodes.size() - 1;
+}
+
+AstIndex AstArena::newList(AstIndex first_item){
+	return add(AST_LIST, 0, 0, first_item, first_item);
+}
+
+void AstArena::append(AstIndex list, AstIndex item){
+	assert(nodes[list].kind == AST_LIST);
+	nodes[nodes[list].b].next = item;
+	nodes[list].b = item;
+}
+
+void AstArena::clear(){
+	nodes.clear();
+}
+
+uint32_t AstArena::intern(const TokenSpan& span){
+	std::string_view text(span.begin, span.length);
+	auto found = name_ids.find(text);
+	if(found != name_ids.end())
+		return found->second;
+	uint32_t id = names.size();
+	names.push_back(std::string(text));
+	name_ids[text] = id;
+	return id;
+}
+
+const std::string& AstArena::name(uint32_t id) const{
+	return names[id];
+}
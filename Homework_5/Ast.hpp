@@ -0,0 +1,87 @@
+#ifndef AST_H
+#define AST_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "AuxTypes.hpp"
+
+//the index of a node in the arena, children are referred to by their index rather than by a pointer:
+typedef uint32_t AstIndex;
+const AstIndex AST_NONE = UINT32_MAX;
+
+/**
+ * @brief the kinds of nodes of the syntax tree of a function body, and the meaning of their fields.
+ * 		'id' fields are interned identifiers (or string literals), see 'AstArena::intern'.
+ */
+enum AstKind : uint8_t{
+	AST_LIST,			//a: first item, b: last item. the items are linked through their 'next' field.
+	AST_BLOCK,			//a: a list of statements.
+	AST_VAR_DEC,		//op: type, a: id, b: is_const. this is the declaration part of AST_DEC_STATEMENT.
+	AST_DEC_STATEMENT,	//a: AST_VAR_DEC, b: the initial value or AST_NONE.
+	AST_ASSIGN,			//a: id, b: the assigned value.
+	AST_CALL_STATEMENT,	//a: AST_CALL.
+	AST_RETURN,			//a: the returned value or AST_NONE.
+	AST_BREAK,
+	AST_CONTINUE,
+	AST_IF,				//a: condition, b: then part, c: else part or AST_NONE.
+	AST_WHILE,			//a: condition, b: body.
+	AST_CALL,			//a: id, b: a list of the arguments or AST_NONE.
+	AST_ID,				//a: id.
+	AST_STRING,			//a: id of the text of the literal.
+	AST_NUM,			//op: type (INT_EXP or BYTE_EXP), a: value.
+	AST_BOOL,			//op: value.
+	AST_CAST,			//op: type, a: the cast value.
+	AST_BINOP,			//op: binop, a, b: operands.
+	AST_RELOP,			//op: relop, a, b: operands.
+	AST_AND,			//a, b: operands.
+	AST_OR,				//a, b: operands.
+	AST_NOT				//a: operand.
+};
+
+//24 bytes, so a function of a few thousand nodes fits in the L1 cache while it is lowered:
+struct AstNode{
+	AstKind kind;
+	uint8_t op;
+	//the line the parser was at when it created the node, errors found while lowering the node are reported at it:
+	int line;
+	AstIndex a;
+	AstIndex b;
+	AstIndex c;
+	AstIndex next;
+};
+
+/**
+ * @brief the nodes of the function that is currently parsed, in a single contiguous vector.
+ * 		the nodes of a subtree are created together while it is parsed, so they are next to each other in the arena.
+ * 		after a function is lowered 'clear' drops its nodes, and the memory is reused for the next function.
+ */
+class AstArena{
+public:
+	AstIndex add(AstKind kind, int line, uint8_t op = 0
+		, AstIndex a = AST_NONE, AstIndex b = AST_NONE, AstIndex c = AST_NONE);
+	const AstNode& operator[](AstIndex index) const{
+		return nodes[index];
+	}
+	AstNode& operator[](AstIndex index){
+		return nodes[index];
+	}
+	//returns a new AST_LIST holding only 'first_item':
+	AstIndex newList(AstIndex first_item);
+	void append(AstIndex list, AstIndex item);
+	//drops every node, identifiers stay interned.
+	void clear();
+
+	//returns the id of the text of 'span', the same text always gets the same id (for the whole compilation).
+	uint32_t intern(const TokenSpan& span);
+	const std::string& name(uint32_t id) const;
+private:
+	std::vector<AstNode> nodes;
+	std::vector<std::string> names;
+	//the keys point into the input buffer, which is kept for the whole compilation:
+	std::unordered_map<std::string_view, uint32_t> name_ids;
+};
+
+#endif
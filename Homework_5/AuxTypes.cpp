@@ -1,6 +1,7 @@
 #include "AuxTypes.hpp"
 #include "bp.hpp"
 #include "assert.h"
+#include <deque>
 
 static CodeBuffer& cb = CodeBuffer::instance();
 
@@ -28,21 +29,54 @@ std::vector<std::string> ExpTypeStringVector(std::vector<ExpType> types, bool ca
 	return result;
 }
 
-Expression::Expression(ExpType type)
-	:type(type){};
+//released expressions are reused, so expressions are only allocated while the pool grows.
+//it is a deque so the expressions keep their addresses when it grows:
+static std::deque<Expression> expression_pool;
+static std::vector<Expression*> free_expressions;
 
-RegStoredExp::RegStoredExp(ExpType type, const string& rvalue_exp, bool store_to_new_reg)
-	:Expression(type){
+Expression* Expression::take(ExpType type){
+	Expression* exp;
+	if(free_expressions.empty()){
+		expression_pool.emplace_back();
+		exp = &expression_pool.back();
+	} else {
+		exp = free_expressions.back();
+		free_expressions.pop_back();
+	}
+	//the strings and vectors are cleared rather than reset, so they keep their buffers:
+	exp->type = type;
+	exp->is_raw_reg = false;
+	exp->reg.clear();
+	exp->var_id.clear();
+	exp->incremented_var_id.clear();
+	exp->truelist.clear();
+	exp->falselist.clear();
+	exp->const_comparison = nullptr;
+	exp->str_length = 0;
+	return exp;
+}
+
+void Expression::release(Expression* exp){
+	free_expressions.push_back(exp);
+}
+
+Expression* Expression::newNumeric(ExpType type, const string& rvalue_exp, bool store_to_new_reg){
+	assert(type == INT_EXP || type == BYTE_EXP);
+	Expression* exp = take(type);
 	if(store_to_new_reg){
-		reg = cb.getFreshReg();
-		cb.emit(reg+" = "+rvalue_exp);
+		exp->reg = cb.emitPureValue(rvalue_exp);
 	} else {
-		reg = rvalue_exp;
+		exp->reg = rvalue_exp;
 	}
+	return exp;
 }
 
-NumericExp::NumericExp(ExpType type, const string& rvalue_exp, bool store_to_new_reg)
-	:RegStoredExp(type, rvalue_exp, store_to_new_reg){}
+Expression* Expression::newRawBool(const string& raw_reg){
+	Expression* exp = take(BOOL_EXP);
+	exp->is_raw_reg = true;
+	exp->reg = raw_reg;
+	return exp;
+}
 
 bool isDigit9001(char c){
 	return '0' <= c && c <= '9';
@@ -55,41 +89,46 @@ bool constValueIsNumLiteral9001(const string& literal){
 	return literal != "";
 }
 
-void NumericExp::convertToInt(){
+void Expression::convertToInt(){
+	assert(type == INT_EXP || type == BYTE_EXP);
 	if(type == BYTE_EXP && !constValueIsNumLiteral9001(reg)){
-		string new_reg = cb.getFreshReg("b2int_conv_reg");
-		cb.emit(new_reg+" = zext i8 "+reg+" to i32");
-		reg = new_reg;
+		reg = cb.emitPureValue("zext i8 "+reg+" to i32", "b2int_conv_reg");
 	}
 	type = INT_EXP;
 }
 
-void NumericExp::convertToByte(){
+void Expression::convertToByte(){
+	assert(type == INT_EXP || type == BYTE_EXP);
 	if(type == INT_EXP){
-		string new_reg = cb.getFreshReg("int2byte_conv_reg");
-		cb.emit(new_reg+" = trunc i32 "+reg+" to i8");
-		reg = new_reg;
+		reg = cb.emitPureValue("trunc i32 "+reg+" to i8", "int2byte_conv_reg");
+		//the truncated value is no longer the value of the variable, or that value plus one:
+		var_id = "";
+		incremented_var_id = "";
 	}
 	type = BYTE_EXP;
 }
-string NumericExp::storeAsRawReg(){
-	string res;
-	if(type == INT_EXP || constValueIsNumLiteral9001(reg)){
-		res = reg;
-	} else {
-		res = cb.getFreshReg("raw_reg");
-		cb.emit(res+" = zext i8 "+reg+" to i32");
-	}
-	return res;
+bool Expression::isLiteral() const{
+	return constValueIsNumLiteral9001(reg);
 }
 
-BoolExp::BoolExp(const std::string rvalue_reg, bool rvalue_reg_is_raw_data)
-	:Expression(BOOL_EXP){
+string Expression::storeAsRawReg(){
+	switch(type){
+	case INT_EXP:
+		return reg;
+	case BYTE_EXP:
+		return constValueIsNumLiteral9001(reg) ? reg : cb.emitPureValue("zext i8 "+reg+" to i32", "raw_reg");
+	case BOOL_EXP:
+		return is_raw_reg ? reg : storeBoolAsRegPrototype(true);
+	default:
+		assert(false);
+		return "";
+	}
+}
 
+Expression* Expression::newBoolFromReg(const std::string& rvalue_reg, bool rvalue_reg_is_raw_data){
 	string bool_value_reg;
 	if(rvalue_reg_is_raw_data){
-		bool_value_reg = cb.getFreshReg();
-		cb.emit(bool_value_reg+" = trunc i32 "+rvalue_reg+" to i1");
+		bool_value_reg = cb.emitPureValue("trunc i32 "+rvalue_reg+" to i1");
 	} else {
 		bool_value_reg = rvalue_reg;
 	}
@@ -97,108 +136,117 @@ BoolExp::BoolExp(const std::string rvalue_reg, bool rvalue_reg_is_raw_data)
 
 	int initial_branch_adderess = cb.emit("br i1 "+bool_value_reg+", label @, label @");
 
-	string true_jump_label = cb.genLabel("true_case");
+	Label true_jump_label = cb.genLabel("true_case");
 	cb.bpatch(cb.makelist(Backpatch(initial_branch_adderess, FIRST)), true_jump_label);
 	int truelist_jump_address = cb.emit("br label @");
 
-	string false_jump_label = cb.genLabel("false_case");
+	Label false_jump_label = cb.genLabel("false_case");
 	cb.bpatch(cb.makelist(Backpatch(initial_branch_adderess, SECOND)), false_jump_label);
 	int falselist_jump_address = cb.emit("br label @");
 	
 	//end_label = cb.genLabel("bool_ending");
-	truelist = cb.makelist(Backpatch(truelist_jump_address, FIRST));
-	falselist = cb.makelist(Backpatch(falselist_jump_address, FIRST));
+	Expression* exp = take(BOOL_EXP);
+	exp->truelist = cb.makelist(Backpatch(truelist_jump_address, FIRST));
+	exp->falselist = cb.makelist(Backpatch(falselist_jump_address, FIRST));
+	return exp;
 }
 
-BoolExp::BoolExp(std::vector<Backpatch> truelist, std::vector<Backpatch> falselist)
-	:Expression(BOOL_EXP), truelist(truelist), falselist(falselist){}
+Expression* Expression::newBool(const std::vector<Backpatch>& truelist, const std::vector<Backpatch>& falselist){
+	Expression* exp = take(BOOL_EXP);
+	exp->truelist = truelist;
+	exp->falselist = falselist;
+	return exp;
+}
 
 
-string BoolExp::storeAsRegPrototype(bool as_raw_reg){
-	string true_label = cb.genLabel("true_case");
+string Expression::storeBoolAsRegPrototype(bool as_raw_reg){
+	assert(type == BOOL_EXP && !is_raw_reg);
+	//an expression that can only jump to one of its lists (like 'true' or 'not false') has a constant value:
+	if(truelist.empty() || falselist.empty()){
+		cb.bpatch(truelist.empty() ? falselist : truelist, cb.genLabel("const_bool"));
+		return truelist.empty() ? "0" : "1";
+	}
+	Label true_label = cb.genLabel("true_case");
 	cb.bpatch(truelist, true_label);
 	int true_jump_addr = cb.emit("br label @");
 	
-	string false_label = cb.genLabel("false_case");
+	Label false_label = cb.genLabel("false_case");
 	cb.bpatch(falselist, false_label);
 	int false_jump_addr = cb.emit("br label @");
 	
-	string bool_reg_label = cb.genLabel("set_bool_reg");
+	Label bool_reg_label = cb.genLabel("set_bool_reg");
 	cb.bpatch(cb.makelist(Backpatch(true_jump_addr, FIRST)), bool_reg_label);
 	cb.bpatch(cb.makelist(Backpatch(false_jump_addr, FIRST)), bool_reg_label);
 	string res_reg = cb.getFreshReg();
 	string resulting_ir_type = as_raw_reg ? "i32" : "i1";
-	cb.emit(res_reg+" = phi "+resulting_ir_type+" [1, %"+true_label+"], [0, %"+false_label+"]");
+	cb.emit(res_reg+" = phi "+resulting_ir_type+" [1, "+cb.nameRef(true_label)+"], [0, "+cb.nameRef(false_label)+"]");
 	return res_reg;
 }
 
-string BoolExp::storeAsReg(){
-	return storeAsRegPrototype(false);
-}
-string BoolExp::storeAsRawReg(){
-	return storeAsRegPrototype(true);
+string Expression::storeAsReg(){
+	return storeBoolAsRegPrototype(false);
 }
 
-int StrExp::str_count = 0;
-std::string StrExp::getFreshStringId(){
-	return "@.string_id"+to_string(StrExp::str_count++);
-}
-
-StrExp::StrExp(const string& value)
-	:Expression(STRING_EXP), llvm_global_id(getFreshStringId()){
+Expression* Expression::newString(const string& value){
+	Expression* exp = take(STRING_EXP);
 	string clipped_value = value.substr(1, value.size()-2);//this removes the quotation marks from the string.
 	
-	ir_type = "[" + to_string(clipped_value.size()+1) + " x i8]";
+	exp->str_length = clipped_value.size();
+	exp->reg = cb.getStringConstant(clipped_value);
+	return exp;
+}
 
-	cb.emitGlobal(llvm_global_id + " = constant "+ir_type+" c\""+ clipped_value + "\\00\"");
+std::string Expression::getPtrValue() const{
+	assert(type == STRING_EXP);
+	string ir_type = "[" + to_string(str_length+1) + " x i8]";
+	return "getelementptr ("+ir_type+", "+ir_type+"* "+reg+", i32 0, i32 0)";
 }
 
-std::string StrExp::loadPtrToReg(){
-	string ptr_reg = cb.getFreshReg("str_ptr_reg");
-	cb.emit(ptr_reg+" = getelementptr "+ir_type+", "+ir_type+"* "+llvm_global_id+", i32 0, i32 0");
-	return ptr_reg;
+Expression* Expression::newVoid(){
+	return take(VOID_EXP);
 }
 
-VoidExp::VoidExp()
-	:Expression(VOID_EXP){};
+Expression* Expression::newUncompiled(ExpType type){
+	return take(type);
+}
 
-BranchBlock::BranchBlock(std::string cond_label, Expression* cond_exp)
+BranchBlock::BranchBlock(Label cond_label, Expression* cond_exp)
 	:cond_label(cond_label){
-	BoolExp* bool_exp = dynamic_cast<BoolExp*>(cond_exp);
-	assert(bool_exp);
-	truelist = bool_exp->truelist;
-	falselist = bool_exp->falselist;
+	assert(cond_exp->type == BOOL_EXP && !cond_exp->is_raw_reg);
+	truelist = cond_exp->truelist;
+	falselist = cond_exp->falselist;
+	const_comparison = cond_exp->const_comparison;
 }	
 
 
-RunBlock::RunBlock(const std::string& start_label)
+RunBlock::RunBlock(Label start_label)
 	:start_label(start_label){}
 
-RunBlock::RunBlock(const std::string& start_label, const RunBlock& first_merge_part, const RunBlock& second_merge_part)
+RunBlock::RunBlock(Label start_label, const RunBlock& first_merge_part, const RunBlock& second_merge_part)
 	:start_label(start_label)
 	, nextlist(cb.merge(first_merge_part.nextlist, second_merge_part.nextlist))
 	, continuelist(cb.merge(first_merge_part.continuelist, second_merge_part.continuelist))
 	, breaklist(cb.merge(first_merge_part.breaklist, second_merge_part.breaklist)){}
 
-RunBlock* RunBlock::newSinkBlockEndingHere(const std::string& block_start_label){
+RunBlock* RunBlock::newSinkBlockEndingHere(Label block_start_label){
 	RunBlock* res = new RunBlock(block_start_label); 
 	res->nextlist = std::vector<Backpatch>();
 	return res;
 }
 
-RunBlock* RunBlock::newBlockEndingHere(const std::string& block_start_label){
+RunBlock* RunBlock::newBlockEndingHere(Label block_start_label){
 	RunBlock* res = new RunBlock(block_start_label); 
 	res->nextlist = cb.makelist(Backpatch(cb.emit("br label @"), FIRST));
 	return res;
 }
 
-RunBlock* RunBlock::newContinueBlockHere(const std::string& block_start_label){
+RunBlock* RunBlock::newContinueBlockHere(Label block_start_label){
 	RunBlock* res = new RunBlock(block_start_label); 
 	res->continuelist = cb.makelist(Backpatch(cb.emit("br label @"), FIRST));
 	return res;
 }
 
-RunBlock* RunBlock::newBreakBlockHere(const std::string& block_start_label){
+RunBlock* RunBlock::newBreakBlockHere(Label block_start_label){
 	RunBlock* res = new RunBlock(block_start_label); 
 	res->breaklist = cb.makelist(Backpatch(cb.emit("br label @"), FIRST));
 	return res;
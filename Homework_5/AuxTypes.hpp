@@ -36,6 +36,9 @@ enum Relop{
 //for an unconditional branch (which contains only a single label) use FIRST.
 enum BranchLabelIndex {FIRST, SECOND};
 typedef std::pair<int, BranchLabelIndex> Backpatch;
+//labels are numbered by the code buffer, see 'CodeBuffer::newName':
+typedef int Label;
+const Label NO_LABEL = -1;
 
 std::string ExpTypeString(ExpType type, bool capital_letters = false);
 std::vector<std::string> ExpTypeStringVector(std::vector<ExpType> types, bool capital_letters = false);
@@ -51,22 +54,29 @@ struct Parameter{
 	bool is_const;
 };
 
+//the text of a token, pointing into the input buffer which is kept for the whole compilation.
+struct TokenSpan{
+	const char* begin;
+	int length;
+	std::string str() const{
+		return std::string(begin, length);
+	}
+};
+
 struct DecInfo{
 	bool is_const;
 	ExpType raw_type;
-	std::string* id;
+	TokenSpan id;
 };
 
 struct FunctionType{
 	/**
 	 * @brief this c'tor uses the 'parameters' param by simply pointing at it as the set of parameters of the function.
 	 * 		as a part of the destruction of the function type, the d'tor will delete this pointer.
-	 * @param parameters_backwards - this is the list of parameters that the function expects.
-	 * 		at the front of this vector there should be the LAST parameter, 
-	 * 		and at the back there should be the FIRST parameter.
+	 * @param parameters - this is the list of parameters that the function expects, from the first to the last.
 	 */
-	FunctionType(ExpType return_type, std::vector<Parameter>* parameters_backwards)
-		:return_type(return_type), parameters(parameters_backwards){}
+	FunctionType(ExpType return_type, std::vector<Parameter>* parameters)
+		:return_type(return_type), parameters(parameters){}
 	FunctionType()
 		:return_type(VOID_EXP), parameters(nullptr){}
 
@@ -76,14 +86,14 @@ struct FunctionType{
 	 */
 	std::vector<ExpType> getParameterTypes() const{
 		std::vector<ExpType> result;
-		for(auto it = parameters->rbegin(); it != parameters->rend(); ++it)
-			result.push_back((*it).type);
+		for(const Parameter& param: *parameters)
+			result.push_back(param.type);
 		return result;
 	}
 	std::vector<std::string> getParameterIds() const{
 		std::vector<std::string> result;
-		for(auto it = parameters->rbegin(); it != parameters->rend(); ++it)
-			result.push_back((*it).id);
+		for(const Parameter& param: *parameters)
+			result.push_back(param.id);
 		return result;
 	}
 	int getNumParameters() const{
@@ -94,76 +104,123 @@ struct FunctionType{
 	std::shared_ptr<std::vector<Parameter>> parameters;
 };
 
-struct Expression{
-	Expression(ExpType type);
-	virtual ~Expression() = default;
-	ExpType type;
-
-	static Expression* generateExpByType(ExpType type);
-
-	class InvalidCastException: public std::exception{};
+/**
+ * @brief describes a condition of the form 'var relop constant' (a 'constant relop var' condition is stored mirrored).
+ * 		such conditions are used for merging if / else-if chains into a switch, and for finding counted loops.
+ */
+struct ConstComparison{
+	std::string var_id;
+	Relop relop;
+	ExpType operand_type;
+	std::string value_reg;
+	std::string constant;
+	int br_address;
 };
 
-struct RegStoredExp: public Expression{
-	RegStoredExp(ExpType type, const std::string& rvalue_exp, bool store_to_new_reg = true);
-	std::string reg;
-
-	static const std::string REG_NOT_ASSIGNED;
-};
-
-struct NumericExp: public RegStoredExp{
-	NumericExp(ExpType type, const std::string& rvalue_exp, bool store_to_new_reg = true);
+/**
+ * @brief the value of an expression. this is a tagged type, 'type' tells which of the fields are used:
+ * 		- INT_EXP, BYTE_EXP: 'reg' holds the value (a register like '$12', see 'CodeBuffer::nameRef', or an immidiate),
+ * 			see 'var_id' and 'incremented_var_id'.
+ * 		- BOOL_EXP: the value is given by jumping to 'truelist' or to 'falselist'.
+ * 			if 'is_raw_reg' is set, 'reg' holds the value as an i32 instead (this is how bools are passed to functions).
+ * 		- STRING_EXP: 'reg' is the id of the global constant that holds the 'str_length' chars of the string.
+ * 		- VOID_EXP: there is no value.
+ * 		expressions are taken from a pool by the 'new...' functions, and 'release' returns them to it to be reused.
+ */
+struct Expression{
+	static Expression* newNumeric(ExpType type, const std::string& rvalue_exp, bool store_to_new_reg = true);
+	static Expression* newBool(const std::vector<Backpatch>& truelist, const std::vector<Backpatch>& falselist);
+	//emits a branch on the bool in 'rvalue_reg' (an i1, or an i32 if 'rvalue_reg_is_raw_data').
+	static Expression* newBoolFromReg(const std::string& rvalue_reg, bool rvalue_reg_is_raw_data);
+	static Expression* newRawBool(const std::string& raw_reg);
+	//'value' is the literal, with the quotation marks.
+	static Expression* newString(const std::string& value);
+	static Expression* newVoid();
+	//an expression of 'type' without a value, for checking a program without generating its code ('--check-only'):
+	static Expression* newUncompiled(ExpType type);
+	static void release(Expression* exp);
+
+	//for numeric expressions:
 	void convertToInt();
 	void convertToByte();
+	bool isLiteral() const;
+	//for numeric and bool expressions, returns the value as an i32 register or immidiate:
 	std::string storeAsRawReg();
-};
-
-struct StrExp: public Expression{
-	StrExp(const std::string& value);
-	std::string loadPtrToReg();
-
-	std::string llvm_global_id;
-	std::string ir_type;
-
-	static int str_count;
-	static std::string getFreshStringId();
-};
-
-struct BoolExp: public Expression{
-	BoolExp(std::vector<Backpatch> truelist, std::vector<Backpatch> falselist);
-	BoolExp(const std::string rvalue_reg, bool rvalue_reg_is_raw_data);
-	std::string storeAsRawReg();
+	//for bool expressions, returns the value as an i1 register or immidiate:
 	std::string storeAsReg();
-	
+	//for string expressions, returns an 'i8*' constant expression that points to the first char of the string.
+	std::string getPtrValue() const;
+
+	ExpType type;
+	bool is_raw_reg;
+	std::string reg;
+	//if this expression is just the value of a variable, this is the id of that variable, otherwise it is empty.
+	std::string var_id;
+	//if this expression is 'var + 1' (or '1 + var'), this is the id of 'var', otherwise it is empty.
+	std::string incremented_var_id;
 	std::vector<Backpatch> truelist;
 	std::vector<Backpatch> falselist;
+	//this is only set if the expression is a single comparison of a variable to a constant:
+	std::shared_ptr<ConstComparison> const_comparison;
+	int str_length;
 private:
-	std::string storeAsRegPrototype(bool as_raw_reg);
-};
-
-struct VoidExp: public Expression{
-	VoidExp();
+	static Expression* take(ExpType type);
+	std::string storeBoolAsRegPrototype(bool as_raw_reg);
 };
 
 struct BranchBlock{
-	BranchBlock(std::string cond_label, Expression* cond_exp);
-	std::string cond_label;
+	BranchBlock(Label cond_label, Expression* cond_exp);
+	Label cond_label;
 	std::vector<Backpatch> truelist;
 	std::vector<Backpatch> falselist;
+	std::shared_ptr<ConstComparison> const_comparison;
+};
+
+/**
+ * @brief the cases of an if / else-if chain in which every condition compares the same variable to a constant.
+ */
+struct SwitchChain{
+	std::string var_id;
+	ExpType operand_type;
+	//pairs of {constant, label to jump to}, ordered as in the source:
+	std::vector<std::pair<std::string, Label>> cases;
+	//if this is NO_LABEL, the default case is not known yet and it will be backpatched through the nextlist.
+	Label default_label = NO_LABEL;
 };
 
 struct RunBlock{
-	RunBlock(const std::string& start_label);
-	RunBlock(const std::string& start_label, const RunBlock& first_merge_part, const RunBlock& second_merge_part);
-	static RunBlock* newBlockEndingHere(const std::string& block_start_label);
-	static RunBlock* newSinkBlockEndingHere(const std::string& block_start_label);
-	static RunBlock* newContinueBlockHere(const std::string& block_start_label);
-	static RunBlock* newBreakBlockHere(const std::string& block_start_label);
-
-	std::string start_label;
+	RunBlock(Label start_label);
+	RunBlock(Label start_label, const RunBlock& first_merge_part, const RunBlock& second_merge_part);
+	static RunBlock* newBlockEndingHere(Label block_start_label);
+	static RunBlock* newSinkBlockEndingHere(Label block_start_label);
+	static RunBlock* newContinueBlockHere(Label block_start_label);
+	static RunBlock* newBreakBlockHere(Label block_start_label);
+
+	Label start_label;
 	std::vector<Backpatch> nextlist;
 	std::vector<Backpatch> continuelist;
 	std::vector<Backpatch> breaklist;
+	//this is only set if the block is an if statement that can be merged into a switch:
+	std::shared_ptr<SwitchChain> switch_chain;
+};
+
+//an assignment to a local variable, kept for finding the induction variables of loops.
+struct VarAssignment{
+	std::string var_id;
+	//the location of the store command in the code buffer:
+	int address;
+	int loop_depth;
+	bool is_increment;
+	//if a numeric literal was assigned this is its value, otherwise it is empty.
+	std::string constant;
+};
+
+//an int multiplication of a variable by a numeric literal, kept for strength reduction in loops.
+struct VarMultiplication{
+	std::string var_id;
+	//the location of the mul command in the code buffer:
+	int address;
+	std::string constant;
 };
 
 struct FuncDecl{
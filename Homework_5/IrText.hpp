@@ -0,0 +1,91 @@
+#ifndef IR_TEXT_H
+#define IR_TEXT_H
+
+#include <string>
+#include <string_view>
+#include <cctype>
+#include "assert.h"
+
+//helpers for reading the commands of the code buffer back, used by the backends that do not print them as text.
+//the commands only use the small part of the llvm syntax that the code buffer emits.
+
+//a position in a command. the words of a command are separated by spaces and commas:
+struct Cursor{
+	std::string_view text;
+	size_t pos = 0;
+
+	void skip(){
+		while(pos < text.size() && (text[pos] == ' ' || text[pos] == ',' || text[pos] == '\t'))
+			++pos;
+	}
+	bool atEnd(){
+		skip();
+		return pos >= text.size();
+	}
+	char peek(){
+		skip();
+		return pos < text.size() ? text[pos] : '\0';
+	}
+	//a word ends at a space, a comma, a bracket or a '*':
+	std::string_view word(){
+		skip();
+		size_t begin = pos;
+		while(pos < text.size() && std::string_view(" ,()[]*").find(text[pos]) == std::string_view::npos)
+			++pos;
+		return text.substr(begin, pos - begin);
+	}
+	void expect(char c){
+		skip();
+		assert(pos < text.size() && text[pos] == c);
+		++pos;
+	}
+	bool eat(std::string_view prefix){
+		skip();
+		if(text.compare(pos, prefix.size(), prefix) != 0)
+			return false;
+		pos += prefix.size();
+		return true;
+	}
+};
+
+inline long long toInt(std::string_view text){
+	bool negative = !text.empty() && text[0] == '-';
+	long long value = 0;
+	for(size_t i = negative ? 1 : 0; i < text.size(); ++i){
+		assert(isdigit(text[i]));
+		value = value * 10 + (text[i] - '0');
+	}
+	return negative ? -value : value;
+}
+
+//the chars of a 'c"..."' constant, with the escapes decoded the way llvm decodes them:
+inline std::string unescape(const std::string& text){
+	std::string chars;
+	for(size_t i = 0; i < text.size(); ++i){
+		if(text[i] == '\\' && i + 1 < text.size() && text[i + 1] == '\\'){
+			chars += '\\';
+			++i;
+		} else if(text[i] == '\\' && i + 2 < text.size() && isxdigit(text[i + 1]) && isxdigit(text[i + 2])){
+			chars += (char)std::stoi(text.substr(i + 1, 2), nullptr, 16);
+			i += 2;
+		} else {
+			chars += text[i];
+		}
+	}
+	return chars;
+}
+
+//calls 'handle' with every line of a buffer entry:
+template<typename Handler>
+void forEachLine(const std::string& commands, Handler handle){
+	size_t line_begin = 0;
+	while(line_begin <= commands.size()){
+		size_t line_end = commands.find('\n', line_begin);
+		if(line_end == std::string::npos)
+			line_end = commands.size();
+		handle(std::string_view(commands).substr(line_begin, line_end - line_begin));
+		line_begin = line_end + 1;
+	}
+}
+
+#endif
@@ -55,8 +55,7 @@ void SimpleSymtab::declareFunc(const string& func_id, ExpType type, vector<Param
 	function_decls[func_id] = FunctionType(type, params);
 
 	int param_offset = 0;
-	for(auto it = params->rbegin(); it != params->rend(); ++it){
-		Parameter& p = *it;
+	for(Parameter& p: *params){
 		assert(declarableValidId(p.id));
 		--param_offset;
 		variable_decls[p.id] = {.type = p.type, .is_const = p.is_const, .offset = param_offset};
@@ -0,0 +1,487 @@
+//the llvm backend of the code buffer, used by 'hw5 --bitcode' and 'hw5 --run' when building with 'make BACKEND=llvm'.
+//the module is built with llvm's IRBuilder from the finished buffers, whose commands only use the small part of the
+//llvm syntax that the code buffer emits. it is then written as bitcode, so lli does not have to parse it as text again,
+//or compiled and run right away with llvm's ORC JIT.
+#ifdef LLVM_BACKEND
+
+#include "bp.hpp"
+#include "IrText.hpp"
+#include "assert.h"
+#include <string_view>
+#include <algorithm>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <cstdio>
+#include <cstdlib>
+using namespace std;
+
+class ModuleBuilder{
+public:
+	//'num_names' is the number of the registers and labels of the code buffer:
+	explicit ModuleBuilder(int num_names)
+		:context(std::make_unique<llvm::LLVMContext>()), module(std::make_unique<llvm::Module>("hw5", *context))
+		, builder(*context), names(num_names){}
+
+	void addLibFuncs(bool printi_used, bool print_used, bool error_if_zero_used, bool declarations_only);
+	//'definition' is a memo table, like '@.memo_valid_f = internal global [4096 x i1] zeroinitializer'.
+	void addGlobal(const string& definition);
+	void addString(const string& id, const string& value);
+	//adds the commands of a single entry of the code buffer.
+	void addCommands(const string& commands);
+	//writes the module to stdout as bitcode:
+	void write();
+	//gives the module to the JIT, the builder should not be used after this.
+	llvm::orc::ThreadSafeModule takeModule();
+private:
+	std::unique_ptr<llvm::LLVMContext> context;
+	std::unique_ptr<llvm::Module> module;
+	llvm::IRBuilder<> builder;
+	std::unordered_map<string, llvm::GlobalVariable*> globals;
+
+	//the value of each register or label of the current function. a name can be used in more than one function
+	//(a specialized copy uses the names of the original), so a value is valid only if 'func' is the current function.
+	struct NameValue{
+		llvm::Value* value = nullptr;
+		int func = -1;
+		//a value that is used before its definition is a placeholder until then:
+		bool defined = false;
+	};
+	vector<NameValue> names;
+	llvm::Function* current_func = nullptr;
+	int func_count = 0;
+
+	void addCommand(string_view command);
+	void beginFunction(string_view command);
+	void defineLabel(int name);
+	//makes sure that the next instruction goes to a block that is not terminated yet:
+	void prepareBlock();
+	void defineName(int name, llvm::Value* value);
+	llvm::Value* nameValue(int name, llvm::Type* type);
+	llvm::BasicBlock* labelBlock(int name);
+
+	llvm::Type* readType(Cursor& cursor);
+	llvm::Value* readValue(Cursor& cursor, llvm::Type* type);
+	llvm::BasicBlock* readLabel(Cursor& cursor);
+	llvm::Value* readCall(Cursor& cursor);
+	llvm::Function* getFunction(const string& id, llvm::FunctionType* type);
+	llvm::GlobalVariable* addConstantString(const string& id, const string& chars);
+};
+
+llvm::Type* ModuleBuilder::readType(Cursor& cursor){
+	llvm::Type* type;
+	if(cursor.peek() == '['){
+		cursor.expect('[');
+		uint64_t size = toInt(cursor.word());
+		cursor.word();//'x'
+		llvm::Type* element_type = readType(cursor);
+		cursor.expect(']');
+		type = llvm::ArrayType::get(element_type, size);
+	} else {
+		string_view name = cursor.word();
+		if(name == "void")
+			type = llvm::Type::getVoidTy(*context);
+		else
+			type = llvm::Type::getIntNTy(*context, toInt(name.substr(1)));
+	}
+	while(cursor.pos < cursor.text.size() && cursor.text[cursor.pos] == '*'){
+		type = type->getPointerTo();
+		++cursor.pos;
+	}
+	return type;
+}
+
+llvm::Value* ModuleBuilder::readValue(Cursor& cursor, llvm::Type* type){
+	string_view word = cursor.word();
+	switch(word[0]){
+	case '$':
+		return nameValue(toInt(word.substr(1)), type);
+	case '%':
+		//the parameters are the unnamed registers:
+		return current_func->getArg(toInt(word.substr(1)));
+	case '@':
+		return globals.at(string(word.substr(1)));
+	}
+	if(word == "getelementptr"){
+		//a pointer to the first char of a string constant, 'getelementptr ([n x i8], [n x i8]* @id, i32 0, i32 0)':
+		cursor.expect('(');
+		llvm::Type* array_type = readType(cursor);
+		readType(cursor);
+		llvm::GlobalVariable* array = llvm::cast<llvm::GlobalVariable>(readValue(cursor, nullptr));
+		while(cursor.peek() != ')')
+			cursor.word();
+		cursor.expect(')');
+		llvm::Constant* zero = builder.getInt32(0);
+		return llvm::ConstantExpr::getGetElementPtr(array_type, array, llvm::ArrayRef<llvm::Constant*>{zero, zero});
+	}
+	return llvm::ConstantInt::getSigned(type, toInt(word));
+}
+
+llvm::BasicBlock* ModuleBuilder::readLabel(Cursor& cursor){
+	string_view word = cursor.word();
+	assert(word[0] == '$');
+	return labelBlock(toInt(word.substr(1)));
+}
+
+llvm::Value* ModuleBuilder::nameValue(int name, llvm::Type* type){
+	NameValue& slot = names[name];
+	if(slot.func != func_count){
+		//a use before the definition, it is replaced when the name is defined:
+		slot = {.value = new llvm::Argument(type), .func = func_count, .defined = false};
+	}
+	return slot.value;
+}
+
+void ModuleBuilder::defineName(int name, llvm::Value* value){
+	NameValue& slot = names[name];
+	if(slot.func == func_count){
+		assert(!slot.defined);
+		slot.value->replaceAllUsesWith(value);
+		slot.value->deleteValue();
+	}
+	slot = {.value = value, .func = func_count, .defined = true};
+}
+
+llvm::BasicBlock* ModuleBuilder::labelBlock(int name){
+	NameValue& slot = names[name];
+	if(slot.func != func_count){
+		//the block is added to the function where its label is defined:
+		slot = {.value = llvm::BasicBlock::Create(*context), .func = func_count, .defined = false};
+	}
+	return llvm::cast<llvm::BasicBlock>(slot.value);
+}
+
+void ModuleBuilder::defineLabel(int name){
+	llvm::BasicBlock* block = labelBlock(name);
+	names[name].defined = true;
+	llvm::BasicBlock* previous = builder.GetInsertBlock();
+	if(previous && !previous->getTerminator())
+		builder.CreateBr(block);
+	block->insertInto(current_func);
+	builder.SetInsertPoint(block);
+}
+
+void ModuleBuilder::prepareBlock(){
+	llvm::BasicBlock* block = builder.GetInsertBlock();
+	if(!block || block->getTerminator())
+		builder.SetInsertPoint(llvm::BasicBlock::Create(*context, "", current_func));
+}
+
+llvm::Function* ModuleBuilder::getFunction(const string& id, llvm::FunctionType* type){
+	return llvm::cast<llvm::Function>(module->getOrInsertFunction(id, type).getCallee());
+}
+
+void ModuleBuilder::beginFunction(string_view command){
+	//'define <return type>@<id>(i32, i32, ...){':
+	size_t at = command.find('@');
+	size_t params_begin = command.find('(', at);
+	Cursor return_type{command.substr(string_view("define ").size(), at - string_view("define ").size())};
+	size_t num_params = 0;
+	if(command[params_begin + 1] != ')')
+		num_params = count(command.begin() + params_begin, command.end(), ',') + 1;
+	llvm::FunctionType* type = llvm::FunctionType::get(readType(return_type)
+		, vector<llvm::Type*>(num_params, builder.getInt32Ty()), false);
+	current_func = getFunction(string(command.substr(at + 1, params_begin - at - 1)), type);
+	++func_count;
+	builder.ClearInsertionPoint();
+}
+
+llvm::Value* ModuleBuilder::readCall(Cursor& cursor){
+	//'call <return type>(<param types>) @<id>(<type> <value>, ...)':
+	llvm::Type* return_type = readType(cursor);
+	vector<llvm::Type*> param_types;
+	cursor.expect('(');
+	while(cursor.peek() != ')')
+		param_types.push_back(readType(cursor));
+	cursor.expect(')');
+	string id(cursor.word().substr(1));
+	vector<llvm::Value*> args;
+	cursor.expect('(');
+	while(cursor.peek() != ')'){
+		llvm::Type* type = readType(cursor);
+		args.push_back(readValue(cursor, type));
+	}
+	cursor.expect(')');
+	return builder.CreateCall(getFunction(id, llvm::FunctionType::get(return_type, param_types, false)), args);
+}
+
+static llvm::Instruction::BinaryOps binaryOp(string_view op){
+	static const unordered_map<string_view, llvm::Instruction::BinaryOps> ops = {
+		{"add", llvm::Instruction::Add}, {"sub", llvm::Instruction::Sub}, {"mul", llvm::Instruction::Mul},
+		{"sdiv", llvm::Instruction::SDiv}, {"udiv", llvm::Instruction::UDiv}, {"shl", llvm::Instruction::Shl},
+		{"lshr", llvm::Instruction::LShr}, {"ashr", llvm::Instruction::AShr}, {"and", llvm::Instruction::And}};
+	return ops.at(op);
+}
+
+static llvm::CmpInst::Predicate comparison(string_view relop){
+	static const unordered_map<string_view, llvm::CmpInst::Predicate> predicates = {
+		{"eq", llvm::CmpInst::ICMP_EQ}, {"ne", llvm::CmpInst::ICMP_NE},
+		{"slt", llvm::CmpInst::ICMP_SLT}, {"sgt", llvm::CmpInst::ICMP_SGT},
+		{"sle", llvm::CmpInst::ICMP_SLE}, {"sge", llvm::CmpInst::ICMP_SGE},
+		{"ult", llvm::CmpInst::ICMP_ULT}, {"ugt", llvm::CmpInst::ICMP_UGT},
+		{"ule", llvm::CmpInst::ICMP_ULE}, {"uge", llvm::CmpInst::ICMP_UGE}};
+	return predicates.at(relop);
+}
+
+void ModuleBuilder::addCommands(const string& commands){
+	forEachLine(commands, [this](string_view command){ addCommand(command); });
+}
+
+void ModuleBuilder::addCommand(string_view command){
+	if(command.empty() || command == "}")
+		return;
+	if(command.compare(0, 7, "define ") == 0){
+		beginFunction(command);
+		return;
+	}
+	if(command[0] == '$' && command.back() == ':'){
+		defineLabel(toInt(command.substr(1, command.size() - 2)));
+		return;
+	}
+
+	Cursor cursor{command};
+	int result_name = -1;
+	if(command[0] == '$'){
+		size_t assignment = command.find(" = ");
+		result_name = toInt(command.substr(1, assignment - 1));
+		cursor.pos = assignment + 3;
+	}
+	prepareBlock();
+	string_view op = cursor.word();
+	llvm::Value* result = nullptr;
+	if(op == "alloca"){
+		result = builder.CreateAlloca(readType(cursor));
+	} else if(op == "getelementptr"){
+		llvm::Type* type = readType(cursor);
+		llvm::Type* ptr_type = readType(cursor);
+		llvm::Value* ptr = readValue(cursor, ptr_type);
+		vector<llvm::Value*> indices;
+		while(!cursor.atEnd()){
+			llvm::Type* index_type = readType(cursor);
+			indices.push_back(readValue(cursor, index_type));
+		}
+		result = builder.CreateGEP(type, ptr, indices);
+	} else if(op == "load"){
+		llvm::Type* type = readType(cursor);
+		llvm::Type* ptr_type = readType(cursor);
+		result = builder.CreateLoad(type, readValue(cursor, ptr_type));
+	} else if(op == "store"){
+		llvm::Type* type = readType(cursor);
+		llvm::Value* value = readValue(cursor, type);
+		llvm::Type* ptr_type = readType(cursor);
+		builder.CreateStore(value, readValue(cursor, ptr_type));
+	} else if(op == "icmp"){
+		llvm::CmpInst::Predicate predicate = comparison(cursor.word());
+		llvm::Type* type = readType(cursor);
+		llvm::Value* first = readValue(cursor, type);
+		result = builder.CreateICmp(predicate, first, readValue(cursor, type));
+	} else if(op == "zext" || op == "sext" || op == "trunc"){
+		llvm::Type* type = readType(cursor);
+		llvm::Value* value = readValue(cursor, type);
+		cursor.word();//'to'
+		llvm::Instruction::CastOps cast = op == "zext" ? llvm::Instruction::ZExt
+			: (op == "sext" ? llvm::Instruction::SExt : llvm::Instruction::Trunc);
+		result = builder.CreateCast(cast, value, readType(cursor));
+	} else if(op == "br"){
+		if(cursor.eat("label")){
+			builder.CreateBr(readLabel(cursor));
+		} else {
+			llvm::Type* type = readType(cursor);
+			llvm::Value* cond = readValue(cursor, type);
+			cursor.word();//'label'
+			llvm::BasicBlock* true_block = readLabel(cursor);
+			cursor.word();//'label'
+			builder.CreateCondBr(cond, true_block, readLabel(cursor));
+		}
+	} else if(op == "switch"){
+		//'switch <type> <value>, label <default> [ <type> <constant>, label <label> ... ]':
+		llvm::Type* type = readType(cursor);
+		llvm::Value* value = readValue(cursor, type);
+		cursor.word();//'label'
+		llvm::SwitchInst* switch_inst = builder.CreateSwitch(value, readLabel(cursor));
+		cursor.expect('[');
+		while(cursor.peek() != ']'){
+			llvm::Type* case_type = readType(cursor);
+			llvm::Value* constant = readValue(cursor, case_type);
+			cursor.word();//'label'
+			switch_inst->addCase(llvm::cast<llvm::ConstantInt>(constant), readLabel(cursor));
+		}
+	} else if(op == "phi"){
+		llvm::Type* type = readType(cursor);
+		llvm::PHINode* phi = builder.CreatePHI(type, 2);
+		while(!cursor.atEnd()){
+			cursor.expect('[');
+			llvm::Value* value = readValue(cursor, type);
+			phi->addIncoming(value, readLabel(cursor));
+			cursor.expect(']');
+		}
+		result = phi;
+	} else if(op == "call"){
+		result = readCall(cursor);
+	} else if(op == "ret"){
+		llvm::Type* type = readType(cursor);
+		if(type->isVoidTy())
+			builder.CreateRetVoid();
+		else
+			builder.CreateRet(readValue(cursor, type));
+	} else {
+		llvm::Instruction::BinaryOps binop = binaryOp(op);
+		llvm::Type* type = readType(cursor);
+		llvm::Value* first = readValue(cursor, type);
+		result = builder.CreateBinOp(binop, first, readValue(cursor, type));
+	}
+	if(result_name != -1)
+		defineName(result_name, result);
+}
+
+void ModuleBuilder::addGlobal(const string& definition){
+	Cursor cursor{definition};
+	string id(cursor.word().substr(1));
+	bool is_memo_table = cursor.eat("= internal global");
+	assert(is_memo_table);
+	llvm::Type* type = readType(cursor);
+	globals[id] = new llvm::GlobalVariable(*module, type, false, llvm::GlobalValue::InternalLinkage
+		, llvm::Constant::getNullValue(type), id);
+}
+
+llvm::GlobalVariable* ModuleBuilder::addConstantString(const string& id, const string& chars){
+	llvm::Constant* array = llvm::ConstantDataArray::getString(*context, chars, true);
+	llvm::GlobalVariable* global = new llvm::GlobalVariable(*module, array->getType(), true
+		, llvm::GlobalValue::ExternalLinkage, array, id);
+	globals[id] = global;
+	return global;
+}
+
+void ModuleBuilder::addString(const string& id, const string& value){
+	addConstantString(id.substr(1), unescape(value));
+}
+
+void ModuleBuilder::addLibFuncs(bool printi_used, bool print_used, bool error_if_zero_used, bool declarations_only){
+	llvm::Type* void_type = builder.getVoidTy();
+	llvm::Type* i32_type = builder.getInt32Ty();
+	llvm::Type* ptr_type = builder.getInt8PtrTy();
+	llvm::FunctionType* printi_type = llvm::FunctionType::get(void_type, {i32_type}, false);
+	llvm::FunctionType* print_type = llvm::FunctionType::get(void_type, {ptr_type}, false);
+	if(declarations_only){
+		if(printi_used)
+			getFunction("printi", printi_type);
+		if(print_used)
+			getFunction("print", print_type);
+		if(error_if_zero_used)
+			getFunction("errorIfZero9001", printi_type);
+		return;
+	}
+	//the same functions as the text of the runtime library in bp.cpp:
+	print_used = print_used || error_if_zero_used;
+	llvm::Function* printf_func = getFunction("printf", llvm::FunctionType::get(i32_type, {ptr_type}, true));
+	auto printWithFormat = [&](const char* func_id, llvm::FunctionType* type, const char* format_id, const char* format){
+		llvm::Function* func = getFunction(func_id, type);
+		llvm::GlobalVariable* specifier = addConstantString(format_id, format);
+		builder.SetInsertPoint(llvm::BasicBlock::Create(*context, "", func));
+		llvm::Value* spec_ptr = builder.CreateConstGEP2_32(specifier->getValueType(), specifier, 0, 0);
+		builder.CreateCall(printf_func, {spec_ptr, func->getArg(0)});
+		builder.CreateRetVoid();
+	};
+	if(printi_used)
+		printWithFormat("printi", printi_type, ".int_specifier", "%d\n");
+	if(print_used)
+		printWithFormat("print", print_type, ".str_specifier", "%s\n");
+	if(error_if_zero_used){
+		llvm::Function* exit_func = getFunction("exit", printi_type);
+		llvm::Function* func = getFunction("errorIfZero9001", printi_type);
+		llvm::GlobalVariable* message = addConstantString(".str_div_zero", "Error division by zero");
+		llvm::BasicBlock* entry = llvm::BasicBlock::Create(*context, "", func);
+		llvm::BasicBlock* exit_block = llvm::BasicBlock::Create(*context, "exit", func);
+		llvm::BasicBlock* return_block = llvm::BasicBlock::Create(*context, "return", func);
+		builder.SetInsertPoint(entry);
+		builder.CreateCondBr(builder.CreateICmpEQ(builder.getInt32(0), func->getArg(0)), exit_block, return_block);
+		builder.SetInsertPoint(exit_block);
+		builder.CreateCall(getFunction("print", print_type)
+			, {builder.CreateConstGEP2_32(message->getValueType(), message, 0, 0)});
+		builder.CreateCall(exit_func, {builder.getInt32(1)});
+		builder.CreateBr(return_block);
+		builder.SetInsertPoint(return_block);
+		builder.CreateRetVoid();
+	}
+	builder.ClearInsertionPoint();
+}
+
+void ModuleBuilder::write(){
+	assert(!llvm::verifyModule(*module, &llvm::errs()));
+	llvm::WriteBitcodeToFile(*module, llvm::outs());
+	llvm::outs().flush();
+}
+
+llvm::orc::ThreadSafeModule ModuleBuilder::takeModule(){
+	assert(!llvm::verifyModule(*module, &llvm::errs()));
+	return llvm::orc::ThreadSafeModule(std::move(module), std::move(context));
+}
+
+void CodeBuffer::fillModule(ModuleBuilder& module, bool lib_declarations_only){
+	module.addLibFuncs(isLibFuncUsed("printi"), isLibFuncUsed("print"), isLibFuncUsed("errorIfZero9001")
+		, lib_declarations_only);
+	//without the library functions, the global buffer only holds the memo tables:
+	for(const string& definition: globalDefs)
+		module.addGlobal(definition);
+	for(const pair<const string, string>& string_id: string_ids){
+		if(!reachability_known || reachable_strings.count(string_id.second) == 1)
+			module.addString(string_id.second, string_id.first);
+	}
+	for(const string& commands: buffer)
+		module.addCommands(commands);
+}
+
+void CodeBuffer::printBitcode(bool lib_declarations_only){
+	ModuleBuilder module(name_hints.size());
+	fillModule(module, lib_declarations_only);
+	module.write();
+}
+
+//the library functions for '--run', they print exactly what the functions of the runtime library print:
+static void nativePrinti(int value){
+	printf("%d\n", value);
+}
+
+static void nativePrint(const char* str){
+	printf("%s\n", str);
+}
+
+static void nativeErrorIfZero9001(int value){
+	if(value == 0){
+		nativePrint("Error division by zero");
+		exit(1);
+	}
+}
+
+void CodeBuffer::runMain(){
+	ModuleBuilder module(name_hints.size());
+	fillModule(module, true);
+	llvm::InitializeNativeTarget();
+	llvm::InitializeNativeTargetAsmPrinter();
+	//the code is only run once, so the time to the first output is mostly the time it takes to compile it:
+	llvm::orc::JITTargetMachineBuilder machine = llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost());
+	machine.setCodeGenOptLevel(llvm::CodeGenOpt::None);
+	std::unique_ptr<llvm::orc::LLJIT> jit = llvm::cantFail(llvm::orc::LLJITBuilder()
+		.setJITTargetMachineBuilder(std::move(machine)).create());
+	//the declared library functions are resolved to the native ones:
+	llvm::orc::SymbolMap natives;
+	auto bindNative = [&](const char* func_id, void* address){
+		natives[jit->mangleAndIntern(func_id)] = llvm::JITEvaluatedSymbol(llvm::pointerToJITTargetAddress(address)
+			, llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+	};
+	bindNative("printi", (void*)&nativePrinti);
+	bindNative("print", (void*)&nativePrint);
+	bindNative("errorIfZero9001", (void*)&nativeErrorIfZero9001);
+	llvm::cantFail(jit->getMainJITDylib().define(llvm::orc::absoluteSymbols(natives)));
+	llvm::cantFail(jit->addIRModule(module.takeModule()));
+	auto main_func = llvm::jitTargetAddressToFunction<void(*)()>(llvm::cantFail(jit->lookup("main")).getAddress());
+	main_func();
+	fflush(stdout);
+}
+
+#endif
@@ -4,12 +4,17 @@
 #include "assert.h"
 #include <vector>
 #include <iostream>
-#include <sstream>
 #include <algorithm>
+#include <map>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <sstream>
 using namespace std;
 extern SimpleSymtab symtab;
 
 bool replace(string& str, const string& from, const string& to, const BranchLabelIndex index);
+string concatWithSpacing(const vector<string>& words, const string& spacing);
 
 CodeBuffer::CodeBuffer() : buffer(), globalDefs() {}
 
@@ -18,35 +23,593 @@ CodeBuffer &CodeBuffer::instance() {
 	return inst;
 }
 
-string CodeBuffer::genLabel(const string& label_name){
-	std::stringstream label;
-	label << label_name;
-	label << "_";
-	label << buffer.size();
-	std::string ret(label.str());
-	label << ":";
-	emit(label.str());
-	return ret;
+Label CodeBuffer::genLabel(const char* label_name){
+	Label label = newName(label_name);
+	label_addresses[label] = emit(nameRef(label) + ":");
+	//this is the start of a new basic block:
+	block_values.clear();
+	return label;
+}
+
+int CodeBuffer::newName(const char* hint){
+	//a hint that ends with a digit could make two names print the same, e.g 'a1' + '2' and 'a' + '12':
+	assert(hint[0] != '\0' && !isdigit(hint[strlen(hint) - 1]));
+	name_hints.push_back(hint);
+	label_addresses.push_back(-1);
+	return name_hints.size() - 1;
+}
+
+string CodeBuffer::nameRef(int name){
+	return "$" + to_string(name);
 }
 
 int CodeBuffer::emit(const string &s){
     buffer.push_back(s);
+	//a terminator ends the basic block:
+	if(s.compare(0, 3, "br ") == 0 || s.compare(0, 3, "ret") == 0 || s.compare(0, 7, "switch ") == 0)
+		block_values.clear();
 	return buffer.size() - 1;
 }
 
-void CodeBuffer::bpatch(const vector<pair<int,BranchLabelIndex>>& address_list, const std::string &label){
+int CodeBuffer::getNextAddress() const{
+	return buffer.size();
+}
+
+int CodeBuffer::labelAddress(Label label) const{
+	assert(label_addresses.at(label) != -1);
+	return label_addresses[label];
+}
+
+const string& CodeBuffer::commandAt(int address) const{
+	return buffer[address];
+}
+
+void CodeBuffer::replaceCommand(int address, const string& command){
+	buffer[address] = command;
+}
+
+void CodeBuffer::appendToCommand(int address, const string& commands){
+	buffer[address] += "\n" + commands;
+}
+
+static bool isNameChar(char c){
+	return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '_' || c == '.';
+}
+
+static bool isIntLiteral(const string& value){
+	size_t first_digit = (!value.empty() && value[0] == '-') ? 1 : 0;
+	return first_digit < value.size() && value.find_first_not_of("0123456789", first_digit) == string::npos;
+}
+
+//replaces each '%name' in 'command' for which 'replacements' has the key 'name' with its value.
+static string replaceNames(const string& command, const unordered_map<string, string>& replacements){
+	string result;
+	size_t pos = 0;
+	while(pos < command.size()){
+		size_t percent = command.find('%', pos);
+		if(percent == string::npos){
+			result += command.substr(pos);
+			break;
+		}
+		size_t name_end = percent + 1;
+		while(name_end < command.size() && isNameChar(command[name_end]))
+			++name_end;
+		auto replacement = replacements.find(command.substr(percent + 1, name_end - percent - 1));
+		if(replacement == replacements.end()){
+			result += command.substr(pos, name_end - pos);
+		} else {
+			result += command.substr(pos, percent - pos) + replacement->second;
+		}
+		pos = name_end;
+	}
+	return result;
+}
+
+//reads the number of a name that starts at 'pos' (right after its '$'), and moves 'pos' to the end of it.
+static int readName(const string& command, size_t& pos){
+	int name = 0;
+	while(pos < command.size() && isdigit(command[pos]))
+		name = name * 10 + (command[pos++] - '0');
+	return name;
+}
+
+//replaces each '$<number>' in 'command' for which 'renames' has the key 'number' with a reference to its value.
+static string renameRefs(const string& command, const unordered_map<int, int>& renames){
+	string result;
+	size_t pos = 0;
+	while(true){
+		size_t ref = command.find('$', pos);
+		if(ref == string::npos)
+			return result.append(command, pos, string::npos);
+		result.append(command, pos, ref - pos);
+		pos = ref + 1;
+		int name = readName(command, pos);
+		auto renamed = renames.find(name);
+		result += CodeBuffer::nameRef(renamed == renames.end() ? name : renamed->second);
+	}
+}
+
+//the number of bits of an integer ir type like 'i32', or 0 for any other type:
+static int irTypeBits(const string& ir_type){
+	if(ir_type.size() < 2 || ir_type[0] != 'i' || ir_type.find_first_not_of("0123456789", 1) != string::npos)
+		return 0;
+	return stoi(ir_type.substr(1));
+}
+
+static uint64_t wrapBits(uint64_t value, int bits){
+	return bits == 64 ? value : value & ((1ULL << bits) - 1);
+}
+
+static int64_t signedValue(uint64_t value, int bits){
+	return (int64_t)(value << (64 - bits)) >> (64 - bits);
+}
+
+//prints a constant of 'bits' bits like the code buffer does, bools and bytes are unsigned:
+static string constantString(uint64_t value, int bits){
+	return bits <= 8 ? to_string(value) : to_string(signedValue(value, bits));
+}
+
+/**
+ * @brief computes an rvalue whose operands are all constants, like 'add i32 3, 4', 'icmp slt i8 200, 3' or 'zext i1 1 to i32',
+ * 		with the same wraparound as in runtime.
+ * @return false if the rvalue is not one of those, or if computing it would fail in runtime (a division by zero).
+ **/
+static bool foldConstantRvalue(const string& rvalue, string& result){
+	istringstream words(rvalue);
+	string op, first, second;
+	words >> op;
+	if(op == "zext" || op == "sext" || op == "trunc"){
+		string from_type, to, to_type;
+		words >> from_type >> first >> to >> to_type;
+		const int from_bits = irTypeBits(from_type), to_bits = irTypeBits(to_type);
+		if(from_bits == 0 || to_bits == 0 || to != "to" || !isIntLiteral(first))
+			return false;
+		uint64_t value = wrapBits(stoll(first), from_bits);
+		if(op == "sext")
+			value = signedValue(value, from_bits);
+		result = constantString(wrapBits(value, to_bits), to_bits);
+		return true;
+	}
+	string predicate, type;
+	if(op == "icmp")
+		words >> predicate;
+	words >> type >> first >> second;
+	const int bits = irTypeBits(type);
+	if(bits == 0 || first.empty() || first.back() != ',')
+		return false;
+	first.pop_back();
+	if(!isIntLiteral(first) || !isIntLiteral(second))
+		return false;
+	const uint64_t a = wrapBits(stoll(first), bits), b = wrapBits(stoll(second), bits);
+	const int64_t signed_a = signedValue(a, bits), signed_b = signedValue(b, bits);
+	if(op == "icmp"){
+		bool holds;
+		if(predicate == "eq")
+			holds = a == b;
+		else if(predicate == "ne")
+			holds = a != b;
+		else if(predicate == "ult" || predicate == "ugt")
+			holds = predicate == "ult" ? a < b : a > b;
+		else if(predicate == "ule" || predicate == "uge")
+			holds = predicate == "ule" ? a <= b : a >= b;
+		else if(predicate == "slt" || predicate == "sgt")
+			holds = predicate == "slt" ? signed_a < signed_b : signed_a > signed_b;
+		else if(predicate == "sle" || predicate == "sge")
+			holds = predicate == "sle" ? signed_a <= signed_b : signed_a >= signed_b;
+		else
+			return false;
+		result = holds ? "1" : "0";
+		return true;
+	}
+	uint64_t value;
+	if(op == "add")
+		value = a + b;
+	else if(op == "sub")
+		value = a - b;
+	else if(op == "mul")
+		value = a * b;
+	else if(op == "and")
+		value = a & b;
+	else if(op == "or")
+		value = a | b;
+	else if(op == "xor")
+		value = a ^ b;
+	else if(op == "udiv" && b != 0)
+		value = a / b;
+	//the minimal value divided by -1 overflows:
+	else if(op == "sdiv" && b != 0 && !(signed_b == -1 && a == (1ULL << (bits - 1))))
+		value = signed_a / signed_b;
+	else if(op == "shl" && b < (uint64_t)bits)
+		value = a << b;
+	else if(op == "lshr" && b < (uint64_t)bits)
+		value = a >> b;
+	else if(op == "ashr" && b < (uint64_t)bits)
+		value = signed_a >> b;
+	else
+		return false;
+	result = constantString(wrapBits(value, bits), bits);
+	return true;
+}
+
+//replaces each '$<number>' in 'command' for which 'values' has the key 'number' with its value.
+static string replaceRefs(const string& command, const unordered_map<int, string>& values){
+	string result;
+	size_t pos = 0;
+	while(true){
+		size_t ref = command.find('$', pos);
+		if(ref == string::npos)
+			return result.append(command, pos, string::npos);
+		result.append(command, pos, ref - pos);
+		pos = ref + 1;
+		int name = readName(command, pos);
+		auto value = values.find(name);
+		result += value == values.end() ? CodeBuffer::nameRef(name) : value->second;
+	}
+}
+
+static bool isTerminator(const string& command){
+	return command.compare(0, 3, "br ") == 0 || command.compare(0, 3, "ret") == 0 || command.compare(0, 7, "switch ") == 0;
+}
+
+//returns the name of the register defined by 'command' (like '$12 = add i32 1, 2'), or -1. 'rvalue_pos' is set to the start of its rvalue.
+static int definedRegister(const string& command, size_t& rvalue_pos){
+	if(command.compare(0, 1, "$") != 0)
+		return -1;
+	size_t name_end = 1;
+	int name = readName(command, name_end);
+	if(command.compare(name_end, 3, " = ") != 0)
+		return -1;
+	rvalue_pos = name_end + 3;
+	return name;
+}
+
+//returns the name of the label defined by 'command' (like '$12:'), or -1:
+static int definedLabel(const string& command){
+	if(command.compare(0, 1, "$") != 0 || command.back() != ':')
+		return -1;
+	size_t name_end = 1;
+	int name = readName(command, name_end);
+	return name_end + 1 == command.size() ? name : -1;
+}
+
+//the labels that 'terminator' can jump to:
+static vector<int> jumpTargets(const string& terminator){
+	vector<int> targets;
+	for(size_t pos = terminator.find("label $"); pos != string::npos; pos = terminator.find("label $", pos)){
+		pos += 7;
+		targets.push_back(readName(terminator, pos));
+	}
+	return targets;
+}
+
+/**
+ * @brief replaces a conditional branch or a switch on a constant with a jump to the target it takes.
+ * @return whether 'terminator' was changed.
+ **/
+static bool foldBranch(string& terminator){
+	istringstream words(terminator);
+	string op, type, value;
+	words >> op >> type >> value;
+	if(value.empty() || value.back() != ',')
+		return false;
+	value.pop_back();
+	if(!isIntLiteral(value) || (op != "br" && op != "switch"))
+		return false;
+	vector<int> targets = jumpTargets(terminator);
+	int target = op == "br" ? targets[value == "0" ? 1 : 0] : targets[0];
+	if(op == "switch"){
+		//'switch <type> <value>, label <default> [ <type> <constant>, label <label> ... ]':
+		const int bits = irTypeBits(type);
+		string case_type, constant, label;
+		words >> label >> label >> label;
+		for(size_t i = 1; i < targets.size() && words >> case_type >> constant >> label >> label; ++i){
+			constant.pop_back();
+			if(wrapBits(stoll(constant), bits) == wrapBits(stoll(value), bits)){
+				target = targets[i];
+				break;
+			}
+		}
+	}
+	terminator = "br label " + CodeBuffer::nameRef(target);
+	return true;
+}
+
+//the rvalues without side effects, whose registers can be removed when they are not used:
+static bool isPureRvalue(const string& command, size_t rvalue_pos){
+	static const set<string> pure_ops = {"add", "sub", "mul", "sdiv", "udiv", "and", "or", "xor", "shl", "lshr", "ashr"
+		, "icmp", "zext", "sext", "trunc", "phi", "load", "getelementptr"};
+	return pure_ops.count(command.substr(rvalue_pos, command.find(' ', rvalue_pos) - rvalue_pos)) == 1;
+}
+
+/**
+ * @brief folds the constants of a function, given as the lines of its definition (e.g a specialized copy, after its constant
+ * 		arguments were put in place of its parameters): the values computed only from constants are replaced by the constants,
+ * 		branches on constants become jumps, the blocks that can no longer be reached are removed (along with their entries in phis),
+ * 		and so are the values that are no longer used, the checks of divisors that are not zero,
+ * 		and the jumps to the next block from its only predecessor.
+ * 		this is repeated until nothing changes.
+ **/
+static void foldConstantCode(vector<string>& lines){
+	//the last line closes the function:
+	assert(lines.size() >= 2 && lines.back() == "}");
+	unordered_map<int, string> values;
+	bool changed = true;
+	while(changed){
+		changed = false;
+		//constants. a value might be used above its definition (e.g in a loop), those uses are replaced in the next round:
+		vector<string> kept_lines;
+		for(string& line: lines){
+			//a replaced value might be a register that was folded too, so replacing is a change as well:
+			if(!values.empty() && line.find('$') != string::npos){
+				string replaced = replaceRefs(line, values);
+				changed |= replaced != line;
+				line.swap(replaced);
+			}
+			size_t rvalue_pos;
+			int reg = definedRegister(line, rvalue_pos);
+			string result;
+			if(reg != -1 && foldConstantRvalue(line.substr(rvalue_pos), result)){
+				values[reg] = result;
+				changed = true;
+				continue;
+			}
+			if(isTerminator(line) && foldBranch(line))
+				changed = true;
+			//a division by a constant that is not zero can not fail:
+			static const string zero_check = "call void(i32) @errorIfZero9001(i32 ";
+			if(line.compare(0, zero_check.size(), zero_check) == 0){
+				string divisor = line.substr(zero_check.size(), line.size() - zero_check.size() - 1);
+				if(isIntLiteral(divisor) && stoll(divisor) != 0){
+					changed = true;
+					continue;
+				}
+			}
+			kept_lines.push_back(line);
+		}
+		lines.swap(kept_lines);
+
+		//reachable blocks. a block starts at a label, or right after a terminator (such a block has no label and is never reached):
+		vector<size_t> block_begins;
+		unordered_map<int, size_t> label_blocks;
+		for(size_t i = 1; i + 1 < lines.size(); ++i){
+			int label = definedLabel(lines[i]);
+			if(i == 1 || label != -1 || isTerminator(lines[i - 1]))
+				block_begins.push_back(i);
+			if(label != -1)
+				label_blocks[label] = block_begins.size() - 1;
+		}
+		block_begins.push_back(lines.size() - 1);
+		const size_t num_blocks = block_begins.size() - 1;
+		vector<vector<size_t>> successors(num_blocks);
+		for(size_t block = 0; block < num_blocks; ++block){
+			const string& last_line = lines[block_begins[block + 1] - 1];
+			if(!isTerminator(last_line)){
+				successors[block].push_back(block + 1);
+				continue;
+			}
+			for(int target: jumpTargets(last_line))
+				successors[block].push_back(label_blocks.at(target));
+		}
+		vector<bool> reachable(num_blocks, false);
+		vector<size_t> to_visit = {0};
+		while(!to_visit.empty()){
+			size_t block = to_visit.back();
+			to_visit.pop_back();
+			if(block >= num_blocks || reachable[block])
+				continue;
+			reachable[block] = true;
+			to_visit.insert(to_visit.end(), successors[block].begin(), successors[block].end());
+		}
+
+		//the phis keep only the entries of reachable blocks that still jump to them, a phi with a single entry is just its value:
+		kept_lines = {lines.front()};
+		for(size_t block = 0; block < num_blocks; ++block){
+			if(!reachable[block]){
+				changed = true;
+				continue;
+			}
+			for(size_t i = block_begins[block]; i < block_begins[block + 1]; ++i){
+				string& line = lines[i];
+				size_t rvalue_pos;
+				int reg = definedRegister(line, rvalue_pos);
+				if(reg == -1 || line.compare(rvalue_pos, 4, "phi ") != 0){
+					kept_lines.push_back(line);
+					continue;
+				}
+				//'$<name> = phi <type> [<value>, $<label>], ...':
+				string phi = line.substr(0, line.find('['));
+				vector<string> entry_values;
+				for(size_t entry = line.find('['); entry != string::npos; entry = line.find('[', entry + 1)){
+					size_t comma = line.find(", $", entry);
+					size_t label_pos = comma + 3;
+					size_t from_block = label_blocks.at(readName(line, label_pos));
+					const vector<size_t>& from_successors = successors[from_block];
+					if(!reachable[from_block] || find(from_successors.begin(), from_successors.end(), block) == from_successors.end())
+						continue;
+					entry_values.push_back(line.substr(entry + 1, comma - entry - 1));
+					phi += (entry_values.size() > 1 ? ", " : "") + line.substr(entry, line.find(']', entry) + 1 - entry);
+				}
+				assert(!entry_values.empty());
+				if(entry_values.size() == 1){
+					values[reg] = entry_values.front();
+					changed = true;
+					continue;
+				}
+				changed |= phi != line;
+				kept_lines.push_back(phi);
+			}
+		}
+		kept_lines.push_back(lines.back());
+		lines.swap(kept_lines);
+
+		//unused values, and jumps to the next line that is the only use of its label:
+		unordered_map<int, int> use_counts;
+		for(const string& line: lines){
+			for(size_t ref = line.find('$'); ref != string::npos; ref = line.find('$', ref)){
+				++ref;
+				++use_counts[readName(line, ref)];
+			}
+		}
+		kept_lines.clear();
+		for(size_t i = 0; i < lines.size(); ++i){
+			const string& line = lines[i];
+			size_t rvalue_pos;
+			int reg = definedRegister(line, rvalue_pos);
+			//the definition itself is counted as a use:
+			if(reg != -1 && use_counts[reg] == 1 && values.count(reg) == 0 && isPureRvalue(line, rvalue_pos)){
+				changed = true;
+				continue;
+			}
+			int next_label = i + 1 < lines.size() ? definedLabel(lines[i + 1]) : -1;
+			if(next_label != -1 && use_counts[next_label] == 2 && line == "br label " + CodeBuffer::nameRef(next_label)){
+				changed = true;
+				++i;
+				continue;
+			}
+			kept_lines.push_back(line);
+		}
+		lines.swap(kept_lines);
+	}
+}
+
+int CodeBuffer::cloneCode(int begin, int end, unordered_map<int, int>& renames){
+	//first give new numbers to all the registers and labels that are defined in the range,
+	//a definition is a line that starts with the name, followed by ' = ' for a register or ':' for a label:
+	for(int address = begin; address < end; ++address){
+		const string& commands = buffer[address];
+		for(size_t line = 0; line != string::npos; line = commands.find('\n', line)){
+			if(commands[line] == '\n')
+				++line;
+			if(commands.compare(line, 1, "$") != 0)
+				continue;
+			size_t name_end = line + 1;
+			int name = readName(commands, name_end);
+			if(commands.compare(name_end, 3, " = ") == 0 || commands.compare(name_end, 1, ":") == 0)
+				renames[name] = newName(name_hints[name]);
+		}
+	}
+
+	block_values.clear();
+	int clone_begin = buffer.size();
+	for(int address = begin; address < end; ++address)
+		emit(renameRefs(buffer[address], renames));
+	block_values.clear();
+	for(const pair<const int, int>& rename: renames){
+		int label_address = label_addresses[rename.first];
+		if(label_address != -1)
+			label_addresses[rename.second] = label_address - begin + clone_begin;
+	}
+	//the copied calls are calls as well:
+	size_t num_call_sites = call_sites.size();
+	for(size_t i = 0; i < num_call_sites; ++i){
+		if(call_sites[i].address < begin || call_sites[i].address >= end)
+			continue;
+		CallSite call = call_sites[i];
+		call.address += clone_begin - begin;
+		for(string& arg: call.args)
+			arg = renameRefs(arg, renames);
+		call_sites.push_back(call);
+	}
+	return clone_begin;
+}
+
+void CodeBuffer::bpatch(const vector<pair<int,BranchLabelIndex>>& address_list, Label label){
+	const string label_ref = nameRef(label);
     for(vector<pair<int,BranchLabelIndex>>::const_iterator i = address_list.begin(); i != address_list.end(); i++){
     	int address = (*i).first;
     	BranchLabelIndex labelIndex = (*i).second;
-		replace(buffer[address], "@", "%" + label, labelIndex);
+		replace(buffer[address], "@", label_ref, labelIndex);
     }
 }
 
+void CodeBuffer::rewriteAsSwitch(int address, const string& value_reg, ExpType type
+		, const vector<pair<string, Label>>& cases, Label default_label){
+	string ir_type = IrType(type);
+	string default_target = default_label == NO_LABEL ? "@" : nameRef(default_label);
+	string command = "switch "+ir_type+" "+value_reg+", label "+default_target+" [";
+	vector<string> used_constants;
+	for(const auto& switch_case: cases){
+		//llvm does not allow duplicate cases, and in an if-else chain only the first one can be taken anyway:
+		if(find(used_constants.begin(), used_constants.end(), switch_case.first) != used_constants.end())
+			continue;
+		used_constants.push_back(switch_case.first);
+		command += " "+ir_type+" "+switch_case.first+", label "+nameRef(switch_case.second);
+	}
+	buffer[address] = command+" ]";
+}
+
+void CodeBuffer::printCommand(const string& command, string& out){
+	size_t pos = 0;
+	while(true){
+		size_t ref = command.find('$', pos);
+		if(ref == string::npos){
+			out.append(command, pos, string::npos);
+			return;
+		}
+		out.append(command, pos, ref - pos);
+		pos = ref + 1;
+		int name = readName(command, pos);
+		//a label definition is the only place where a name is written without a '%' before it:
+		if(!((ref == 0 || command[ref - 1] == '\n') && command[pos] == ':'))
+			out += '%';
+		if(compact_output){
+			appendCompactName(name, out);
+		} else {
+			out += name_hints[name];
+			out += to_string(name);
+		}
+	}
+}
+
+void CodeBuffer::appendCompactName(int name, string& out){
+	if(printed_names_func[name] != printed_func){
+		printed_names_func[name] = printed_func;
+		printed_names[name] = printed_names_count++;
+	}
+	//a name can not start with a digit, those are the unnamed registers (like the parameters):
+	static const char NAME_CHARS[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789._";
+	const int NUM_FIRST_CHARS = 52, NUM_CHARS = 64;
+	int index = printed_names[name];
+	out += NAME_CHARS[index % NUM_FIRST_CHARS];
+	for(index /= NUM_FIRST_CHARS; index > 0; index = (index - 1) / NUM_CHARS)
+		out += NAME_CHARS[(index - 1) % NUM_CHARS];
+}
+
+//drops the spaces that llvm does not need: indentation, and the spaces after commas and around '='.
+static void compactSpacing(string& line){
+	size_t length = 0;
+	for(size_t i = 0; i < line.size(); ++i){
+		char prev = length == 0 ? '\n' : line[length - 1];
+		bool is_space = line[i] == ' ' || line[i] == '\t';
+		if(is_space && (prev == '\n' || prev == ',' || prev == '=' || line.compare(i, 2, " =") == 0))
+			continue;
+		line[length++] = line[i];
+	}
+	line.resize(length);
+}
+
 void CodeBuffer::printCodeBuffer(){
+	if(compact_output){
+		printed_names.resize(name_hints.size());
+		printed_names_func.assign(name_hints.size(), -1);
+	}
+	string line;
 	for (std::vector<string>::const_iterator it = buffer.begin(); it != buffer.end(); ++it) 
 	{
-		cout << *it << endl;
-    }
+		if(compact_output && it->compare(0, 7, "define ") == 0){
+			++printed_func;
+			printed_names_count = 0;
+		}
+		line.clear();
+		printCommand(*it, line);
+		if(compact_output)
+			compactSpacing(line);
+		cout << line << '\n';
+	}
+}
+
+void CodeBuffer::setCompactOutput(bool compact){
+	compact_output = compact;
 }
 
 vector<Backpatch> CodeBuffer::makelist(Backpatch item)
@@ -76,8 +639,31 @@ void CodeBuffer::printGlobalBuffer()
 {
 	for (vector<string>::const_iterator it = globalDefs.begin(); it != globalDefs.end(); ++it)
 	{
-		cout << *it << endl;
+		if(compact_output){
+			string line = *it;
+			compactSpacing(line);
+			cout << line << endl;
+		} else {
+			cout << *it << endl;
+		}
+	}
+	for(const pair<string, string>& string_def: string_defs){
+		if(!reachability_known || reachable_strings.count(string_def.first) == 1)
+			cout << string_def.second << endl;
+	}
+}
+
+string CodeBuffer::getStringConstant(const string& value){
+	auto string_id = string_ids.find(value);
+	if(string_id == string_ids.end()){
+		string id = (compact_output ? "@.s" : "@.string_id")+to_string(string_defs.size());
+		string ir_type = "[" + to_string(value.size()+1) + " x i8]";
+		string_defs.push_back({id, id + " = constant "+ir_type+" c\""+ value + "\\00\""});
+		string_id = string_ids.insert({value, id}).first;
 	}
+	if(!current_func.empty())
+		func_sections[current_func].strings.insert(string_id->second);
+	return string_id->second;
 }
 
 // ******** Helper Methods ********** //
@@ -95,37 +681,305 @@ bool replace(string& str, const string& from, const string& to, const BranchLabe
     return true;
 }
 
-void CodeBuffer::emitLibFuncs(){
-	emitGlobal("declare i32 @printf(i8*, ...)");
-	emitGlobal("declare void @exit(i32)");
-	emitGlobal("@.int_specifier = constant [4 x i8] c\"%d\\0A\\00\"");
-	emitGlobal("@.str_specifier = constant [4 x i8] c\"%s\\0A\\00\"");
-	emitGlobal("define void @printi(i32) {");
-	emitGlobal("    %spec_ptr = getelementptr [4 x i8], [4 x i8]* @.int_specifier, i32 0, i32 0");
-	emitGlobal("    call i32 (i8*, ...) @printf(i8* %spec_ptr, i32 %0)");
-	emitGlobal("    ret void");
-	emitGlobal("}");
-	emitGlobal("define void @print(i8*) {");
-	emitGlobal("    %spec_ptr = getelementptr [4 x i8], [4 x i8]* @.str_specifier, i32 0, i32 0");
-	emitGlobal("    call i32 (i8*, ...) @printf(i8* %spec_ptr, i8* %0)");
-	emitGlobal("    ret void");
-	emitGlobal("}");
-	emitGlobal("@.str_div_zero = constant [23 x i8] c\"Error division by zero\\00\"");
-	emitGlobal("define void @errorIfZero9001(i32) {");
-	emitGlobal("	%cond = icmp eq i32 0, %0");
-	emitGlobal("	br i1 %cond, label %exit, label %return");
-	emitGlobal("exit:");
-	emitGlobal("	%err_str_ptr = getelementptr [23 x i8], [23 x i8]* @.str_div_zero, i32 0, i32 0");
-	emitGlobal("	call void(i8*) @print(i8* %err_str_ptr)");
-	emitGlobal("	call void(i32) @exit(i32 1)");
-	emitGlobal("	br label %return");
-	emitGlobal("return:");
-	emitGlobal("	ret void");
-	emitGlobal("}");
-	
+bool CodeBuffer::isLibFuncUsed(const string& func_id) const{
+	return !reachability_known || reachable_funcs.count(func_id) == 1;
+}
+
+//the runtime library is kept as ready made text, each part is emitted as a single entry of the global buffer:
+static const char* const PRINTF_DECL = "declare i32 @printf(i8*, ...)";
+static const char* const EXIT_DECL = "declare void @exit(i32)";
+static const char* const PRINTI_DEF = R"(@.int_specifier = constant [4 x i8] c"%d\0A\00"
+define void @printi(i32) {
+    %spec_ptr = getelementptr [4 x i8], [4 x i8]* @.int_specifier, i32 0, i32 0
+    call i32 (i8*, ...) @printf(i8* %spec_ptr, i32 %0)
+    ret void
+})";
+static const char* const PRINT_DEF = R"(@.str_specifier = constant [4 x i8] c"%s\0A\00"
+define void @print(i8*) {
+    %spec_ptr = getelementptr [4 x i8], [4 x i8]* @.str_specifier, i32 0, i32 0
+    call i32 (i8*, ...) @printf(i8* %spec_ptr, i8* %0)
+    ret void
+})";
+static const char* const ERROR_IF_ZERO_DEF = R"(@.str_div_zero = constant [23 x i8] c"Error division by zero\00"
+define void @errorIfZero9001(i32) {
+	%cond = icmp eq i32 0, %0
+	br i1 %cond, label %exit, label %return
+exit:
+	%err_str_ptr = getelementptr [23 x i8], [23 x i8]* @.str_div_zero, i32 0, i32 0
+	call void(i8*) @print(i8* %err_str_ptr)
+	call void(i32) @exit(i32 1)
+	br label %return
+return:
+	ret void
+})";
+
+void CodeBuffer::emitLibFuncs(bool declarations_only){
+	if(declarations_only){
+		if(isLibFuncUsed("printi"))
+			emitGlobal("declare void @printi(i32)");
+		if(isLibFuncUsed("print"))
+			emitGlobal("declare void @print(i8*)");
+		if(isLibFuncUsed("errorIfZero9001"))
+			emitGlobal("declare void @errorIfZero9001(i32)");
+		return;
+	}
+	//errorIfZero9001 prints its error message using print:
+	bool print_used = isLibFuncUsed("print") || isLibFuncUsed("errorIfZero9001");
+	bool printi_used = isLibFuncUsed("printi");
+	if(print_used || printi_used)
+		emitGlobal(PRINTF_DECL);
+	if(printi_used)
+		emitGlobal(PRINTI_DEF);
+	if(print_used)
+		emitGlobal(PRINT_DEF);
+	if(isLibFuncUsed("errorIfZero9001")){
+		emitGlobal(EXIT_DECL);
+		emitGlobal(ERROR_IF_ZERO_DEF);
+	}
+}
+
+void CodeBuffer::printLibModule(){
+	for(const char* lib_part: {PRINTF_DECL, EXIT_DECL, PRINTI_DEF, PRINT_DEF, ERROR_IF_ZERO_DEF})
+		cout << lib_part << endl;
+}
+
+void CodeBuffer::emitFuncEnd(){
+	assert(func_sections.count(current_func) == 1);
+	FuncSection& section = func_sections[current_func];
+	section.code_end = buffer.size();
+	section.globals_end = globalDefs.size();
+	section.is_pure = calleesArePure(current_func);
+	current_func = "";
+}
+
+bool CodeBuffer::isPureFunc(const string& func_id) const{
+	//errorIfZero9001 only prints right before terminating the program:
+	if(func_id == "errorIfZero9001")
+		return true;
+	//print and printi have no section:
+	if(func_sections.count(func_id) == 0)
+		return false;
+	return func_sections.at(func_id).is_pure;
+}
+
+bool CodeBuffer::calleesArePure(const string& func_id) const{
+	for(const string& callee: func_sections.at(func_id).callees){
+		//a function can only call itself or functions that were already fully parsed:
+		if(callee != func_id && !isPureFunc(callee))
+			return false;
+	}
+	return true;
+}
+
+bool CodeBuffer::isMemoizable(const string& func_id) const{
+	if(func_sections.count(func_id) == 0 || func_sections.at(func_id).callees.count(func_id) == 0)
+		return false;
+	FunctionType& func_type = symtab.getFunctionType(func_id);
+	if(func_type.return_type == VOID_EXP || func_type.return_type == STRING_EXP || func_type.getNumParameters() == 0)
+		return false;
+	for(ExpType type: func_type.getParameterTypes()){
+		if(type == STRING_EXP)
+			return false;
+	}
+	return calleesArePure(func_id);
+}
+
+void CodeBuffer::emitMemoization(const string& func_id, int entry_address){
+	assert(func_id == current_func && isMemoizable(func_id));
+	FunctionType& func_type = symtab.getFunctionType(func_id);
+	const int num_params = func_type.getNumParameters();
+	const string ret_ir_type = IrType(func_type.return_type);
+	const string table_size = to_string(MEMO_TABLE_SIZE);
+	const string valid_ir_type = "[" + table_size + " x i1]";
+	const string keys_ir_type = "[" + table_size + " x [" + to_string(num_params) + " x i32]]";
+	const string values_ir_type = "[" + table_size + " x " + ret_ir_type + "]";
+	const string valid_table = "@.memo_valid_" + func_id;
+	const string keys_table = "@.memo_keys_" + func_id;
+	const string values_table = "@.memo_values_" + func_id;
+	emitGlobal(valid_table + " = internal global " + valid_ir_type + " zeroinitializer");
+	emitGlobal(keys_table + " = internal global " + keys_ir_type + " zeroinitializer");
+	emitGlobal(values_table + " = internal global " + values_ir_type + " zeroinitializer");
+
+	//the lookup is a list of commands that will be added before the first branch of the function:
+	vector<string> lookup;
+	string hash_reg = "%0";
+	for(int i = 1; i < num_params; ++i){
+		string mult_reg = getFreshReg("memo_hash");
+		lookup.push_back(mult_reg + " = mul i32 " + hash_reg + ", 31");
+		hash_reg = getFreshReg("memo_hash");
+		lookup.push_back(hash_reg + " = add i32 " + mult_reg + ", %" + to_string(i));
+	}
+	string index_reg = getFreshReg("memo_index");
+	lookup.push_back(index_reg + " = and i32 " + hash_reg + ", " + to_string(MEMO_TABLE_SIZE - 1));
+	string valid_ptr = getFreshReg("memo_valid_ptr");
+	lookup.push_back(valid_ptr + " = getelementptr " + valid_ir_type + ", " + valid_ir_type + "* " + valid_table + ", i32 0, i32 " + index_reg);
+	string hit_reg = getFreshReg("memo_hit");
+	lookup.push_back(hit_reg + " = load i1, i1* " + valid_ptr);
+	vector<string> key_ptrs;
+	for(int i = 0; i < num_params; ++i){
+		string key_ptr = getFreshReg("memo_key_ptr");
+		lookup.push_back(key_ptr + " = getelementptr " + keys_ir_type + ", " + keys_ir_type + "* " + keys_table
+			+ ", i32 0, i32 " + index_reg + ", i32 " + to_string(i));
+		key_ptrs.push_back(key_ptr);
+		string key_reg = getFreshReg("memo_key");
+		lookup.push_back(key_reg + " = load i32, i32* " + key_ptr);
+		string key_match_reg = getFreshReg("memo_key_match");
+		lookup.push_back(key_match_reg + " = icmp eq i32 " + key_reg + ", %" + to_string(i));
+		string new_hit_reg = getFreshReg("memo_hit");
+		lookup.push_back(new_hit_reg + " = and i1 " + hit_reg + ", " + key_match_reg);
+		hit_reg = new_hit_reg;
+	}
+	string value_ptr = getFreshReg("memo_value_ptr");
+	lookup.push_back(value_ptr + " = getelementptr " + values_ir_type + ", " + values_ir_type + "* " + values_table + ", i32 0, i32 " + index_reg);
+	string hit_label = nameRef(newName("memo_hit"));
+	string miss_label = nameRef(newName("memo_miss"));
+	lookup.push_back("br i1 " + hit_reg + ", label " + hit_label + ", label " + miss_label);
+	lookup.push_back(hit_label + ":");
+	string cached_reg = getFreshReg("memo_cached");
+	lookup.push_back(cached_reg + " = load " + ret_ir_type + ", " + ret_ir_type + "* " + value_ptr);
+	lookup.push_back("ret " + ret_ir_type + " " + cached_reg);
+	lookup.push_back(miss_label + ":");
+	lookup.push_back(buffer[entry_address]);
+	buffer[entry_address] = concatWithSpacing(lookup, "\n");
+
+	for(int ret_address: func_sections[func_id].ret_addresses){
+		//the returned value is the last word of the return command:
+		const string& ret_command = buffer[ret_address];
+		string ret_value = ret_command.substr(ret_command.find_last_of(' ') + 1);
+		vector<string> store;
+		store.push_back("store i1 1, i1* " + valid_ptr);
+		for(int i = 0; i < num_params; ++i)
+			store.push_back("store i32 %" + to_string(i) + ", i32* " + key_ptrs[i]);
+		store.push_back("store " + ret_ir_type + " " + ret_value + ", " + ret_ir_type + "* " + value_ptr);
+		store.push_back(ret_command);
+		buffer[ret_address] = concatWithSpacing(store, "\n");
+	}
+}
+
+int CodeBuffer::specializeFuncs(int max_clones){
+	//a function together with the constant arguments passed to it, as pairs of {parameter index, value}:
+	typedef pair<string, vector<pair<int, string>>> ConstPattern;
+	vector<ConstPattern> call_patterns(call_sites.size());
+	map<ConstPattern, int> pattern_counts;
+	vector<ConstPattern> patterns;
+	for(size_t i = 0; i < call_sites.size(); ++i){
+		const CallSite& call = call_sites[i];
+		//library functions have no section to copy:
+		if(func_sections.count(call.callee) == 0)
+			continue;
+		ConstPattern pattern = {call.callee, {}};
+		for(size_t param = 0; param < call.args.size(); ++param){
+			string value = call.args[param].substr(call.args[param].find(' ') + 1);
+			if(isIntLiteral(value))
+				pattern.second.push_back({param, value});
+		}
+		if(pattern.second.empty())
+			continue;
+		call_patterns[i] = pattern;
+		if(pattern_counts[pattern]++ == 0)
+			patterns.push_back(pattern);
+	}
+	//the most common patterns are specialized first, ties are broken by the order of appearance:
+	stable_sort(patterns.begin(), patterns.end(), [&pattern_counts](const ConstPattern& p1, const ConstPattern& p2){
+		return pattern_counts[p1] > pattern_counts[p2];
+	});
+	if((int)patterns.size() > max_clones)
+		patterns.resize(max(0, max_clones));
+
+	map<ConstPattern, string> clone_ids;
+	for(size_t i = 0; i < patterns.size(); ++i)
+		clone_ids[patterns[i]] = patterns[i].first + ".spec" + to_string(i);
+
+	//redirect the calls before copying, so calls inside the copied functions are redirected as well:
+	for(size_t i = 0; i < call_sites.size(); ++i){
+		CallSite& call = call_sites[i];
+		auto clone_id = clone_ids.find(call_patterns[i]);
+		if(clone_id == clone_ids.end())
+			continue;
+		string& command = buffer[call.address];
+		string old_target = "@" + call.callee + "(";
+		size_t target_pos = command.find(old_target);
+		assert(target_pos != string::npos);
+		command.replace(target_pos, old_target.size(), "@" + clone_id->second + "(");
+		call.callee = clone_id->second;
+	}
+	for(const string& func_id: func_sections_order)
+		func_sections[func_id].callees.clear();
+	for(const CallSite& call: call_sites){
+		if(!call.caller.empty())
+			func_sections[call.caller].callees.insert(call.callee);
+	}
+
+	for(const ConstPattern& pattern: patterns){
+		const string& func_id = pattern.first;
+		const string& clone_id = clone_ids[pattern];
+		//parameters are the unnamed registers '%0', '%1', ...:
+		unordered_map<string, string> constant_params;
+		for(const pair<int, string>& constant_arg: pattern.second)
+			constant_params[to_string(constant_arg.first)] = constant_arg.second;
+
+		FuncSection section = func_sections[func_id];
+		string decl = buffer[section.code_begin];
+		decl.replace(decl.find("@" + func_id + "("), func_id.size() + 2, "@" + clone_id + "(");
+		vector<string> lines = {decl};
+		for(int address = section.code_begin + 1; address < section.code_end; ++address){
+			string commands = replaceNames(buffer[address], constant_params);
+			for(size_t line = 0, line_end = 0; line_end != string::npos; line = line_end + 1){
+				line_end = commands.find('\n', line);
+				lines.push_back(commands.substr(line, line_end - line));
+			}
+		}
+		foldConstantCode(lines);
+		int clone_begin = buffer.size();
+		buffer.insert(buffer.end(), lines.begin(), lines.end());
+
+		func_sections_order.push_back(clone_id);
+		func_sections[clone_id] = {.code_begin = clone_begin, .code_end = (int)buffer.size()
+			, .globals_begin = (int)globalDefs.size(), .globals_end = (int)globalDefs.size()
+			, .callees = section.callees, .ret_addresses = {}, .is_pure = section.is_pure, .origin = func_id
+			, .strings = section.strings};
+	}
+	return patterns.size();
+}
+
+void CodeBuffer::removeUnreachableFuncs(const string& root_func_id){
+	reachable_funcs.clear();
+	vector<string> to_visit = {root_func_id};
+	while(!to_visit.empty()){
+		string func_id = to_visit.back();
+		to_visit.pop_back();
+		if(reachable_funcs.count(func_id) == 1)
+			continue;
+		reachable_funcs.insert(func_id);
+		//library functions have no section:
+		if(func_sections.count(func_id) == 0)
+			continue;
+		for(const string& callee: func_sections[func_id].callees)
+			to_visit.push_back(callee);
+	}
+	reachability_known = true;
+	//specialized copies use the memo tables of the function they were copied from:
+	set<string> globals_in_use;
+	reachable_strings.clear();
+	for(const string& func_id: reachable_funcs){
+		if(func_sections.count(func_id) == 0)
+			continue;
+		const FuncSection& section = func_sections[func_id];
+		globals_in_use.insert(section.origin.empty() ? func_id : section.origin);
+		reachable_strings.insert(section.strings.begin(), section.strings.end());
+	}
+
+	//the sections are erased from last to first so the positions of the earlier ones remain valid:
+	for(auto it = func_sections_order.rbegin(); it != func_sections_order.rend(); ++it){
+		const FuncSection& section = func_sections[*it];
+		if(reachable_funcs.count(*it) == 0)
+			buffer.erase(buffer.begin() + section.code_begin, buffer.begin() + section.code_end);
+		if(globals_in_use.count(*it) == 0)
+			globalDefs.erase(globalDefs.begin() + section.globals_begin, globalDefs.begin() + section.globals_end);
+	}
 }
 
-string CodeBuffer::emitCopyReg(const string& src_reg_or_imm, ExpType src_reg_type, const string& new_reg_prefix){
+string CodeBuffer::emitCopyReg(const string& src_reg_or_imm, ExpType src_reg_type, const char* new_reg_prefix){
 	string new_reg = getFreshReg(new_reg_prefix);
 	string ir_type = IrType(src_reg_type);
 	emit(new_reg+" = add "+ir_type+" 0, "+src_reg_or_imm);
@@ -137,32 +991,15 @@ string CodeBuffer::emitCopyReg(const string& src_reg_or_imm, ExpType src_reg_typ
 // 	return lvalue_id;
 // }
 
-string storeBoolOrNumericAsRawReg(Expression* exp){
-	ExpType type = exp->type;
-	assert(type == BOOL_EXP || type == INT_EXP || type == BYTE_EXP);
-	string res_reg;
-	if(type == BOOL_EXP){
-		BoolExp* bool_exp = dynamic_cast<BoolExp*>(exp);
-		assert(bool_exp);
-		res_reg = bool_exp->storeAsRawReg();
-	} else {
-		NumericExp* numeric_exp = dynamic_cast<NumericExp*>(exp);
-		assert(numeric_exp);
-		res_reg = numeric_exp->storeAsRawReg();
-	}
-	return res_reg;
-}
-
-void CodeBuffer::emitStoreVar(const string& id, Expression* exp_to_assign){
+int CodeBuffer::emitStoreVar(const string& id, Expression* exp_to_assign){
 	ExpType type = exp_to_assign->type;
 	assert(type != STRING_EXP && type != VOID_EXP);
 
-	string res_reg = storeBoolOrNumericAsRawReg(exp_to_assign);
-	emitStoreVarBasic(id, res_reg);
+	return emitStoreVarBasic(id, exp_to_assign->storeAsRawReg());
 }
 
-void CodeBuffer::emitStoreVar(const string& id, const string& reg_or_immidiate){
-	emitStoreVarBasic(id, reg_or_immidiate);
+int CodeBuffer::emitStoreVar(const string& id, const string& reg_or_immidiate){
+	return emitStoreVarBasic(id, reg_or_immidiate);
 }
 
 string paramRegisterAtOffset(int offset){
@@ -179,10 +1016,7 @@ Expression* CodeBuffer::emitLoadVar(const string& id){
 	string raw_value_reg;
 	if(offset >= 0){
 		//if this identifier is a local variable:
-		string param_ptr = getFreshReg("param_ptr");
-		emit(param_ptr+" = getelementptr [50 x i32], [50 x i32]* %sp, i32 0, i32 "+to_string(offset));
-		raw_value_reg = getFreshReg("param_raw");
-		emit(raw_value_reg+" = load i32, i32* "+param_ptr);
+		raw_value_reg = emitLoadStackVar(offset);
 	} else {
 		//if this id is a parameter:
 		raw_value_reg = paramRegisterAtOffset(offset);
@@ -234,17 +1068,16 @@ Expression* CodeBuffer::createIdentifiableFromReg(const string& reg_name, ExpTyp
 	string truncated_value_reg;
 	switch(type){
 	case INT_EXP:
-		return new NumericExp(INT_EXP, "add i32 0, "+reg_name);
+		return Expression::newNumeric(INT_EXP, "add i32 0, "+reg_name);
 	case BYTE_EXP:
 		if(rvalue_reg_is_raw_data){
-			truncated_value_reg = getFreshReg("truncated_byte");
-			emit(truncated_value_reg+" = trunc i32 "+reg_name+" to i8");
+			truncated_value_reg = emitPureValue("trunc i32 "+reg_name+" to i8", "truncated_byte");
 		} else {
 			truncated_value_reg = reg_name;
 		}
-		return new NumericExp(BYTE_EXP, "add i8 0, "+truncated_value_reg);
+		return Expression::newNumeric(BYTE_EXP, "add i8 0, "+truncated_value_reg);
 	case BOOL_EXP:
-		return new BoolExp(reg_name, rvalue_reg_is_raw_data);
+		return Expression::newBoolFromReg(reg_name, rvalue_reg_is_raw_data);
 	}
 	assert(false);
 	return nullptr;
@@ -260,33 +1093,31 @@ Expression* CodeBuffer::emitFunctionCall(const string& func_id, const vector<Exp
 		string new_typed_reg;
 		switch(exp->type){
 		case STRING_EXP:
-			new_typed_reg = "i8* " + dynamic_cast<StrExp*>(exp)->loadPtrToReg();
+			new_typed_reg = "i8* " + exp->getPtrValue();
 			break;
-		case BOOL_EXP: {
-			RegStoredExp* reg_bool_exp = dynamic_cast<RegStoredExp*>(exp);
-			assert(reg_bool_exp);
-			new_typed_reg = "i32 " +  reg_bool_exp->reg;
+		case BOOL_EXP:
+			assert(exp->is_raw_reg);
+			new_typed_reg = "i32 " +  exp->reg;
 			break;
-		}
 		default:
-			NumericExp* numeric_exp = dynamic_cast<NumericExp*>(exp);
-			assert(numeric_exp);
-			new_typed_reg = "i32 " + numeric_exp->storeAsRawReg();
+			new_typed_reg = "i32 " + exp->storeAsRawReg();
 		}
 		param_raw_value_regs.push_back(new_typed_reg);
 	}
-	//this is since we have recived the parameters in reverse order:
-	reverse(param_raw_value_regs.begin(), param_raw_value_regs.end());
 
 	ExpType return_type = symtab.getReturnType(func_id);
 	
+	if(!current_func.empty())
+		func_sections[current_func].callees.insert(func_id);
+	call_sites.push_back({.address = getNextAddress(), .caller = current_func, .callee = func_id, .args = param_raw_value_regs});
+
 	string ir_params_list = concatWithSpacing(param_raw_value_regs, ", ");
 	string ir_func_type = IrFuncTypeFormat(func_id);
 	string call_format = "call "+ir_func_type+" @"+func_id+"("+ir_params_list+")";
 	
 	if(return_type == VOID_EXP){
 		emit(call_format);
-		return new VoidExp();
+		return Expression::newVoid();
 	} else {
 		//this code will emit a function call with all generated registers:
 		string result_reg = getFreshReg();
@@ -298,13 +1129,21 @@ Expression* CodeBuffer::emitFunctionCall(const string& func_id, const vector<Exp
 }
 
 
-void CodeBuffer::emitStoreVarBasic(const string& id, const string& immidiate_or_reg){
+int CodeBuffer::emitStoreVarBasic(const string& id, const string& immidiate_or_reg){
 	int offset = symtab.getVariableOffset(id);
 	ExpType var_type = symtab.getVariableType(id);
 	assert(offset >= 0);
 	//this means that the parameter has to be a local variable, hence stored on stack:
 	string ptr = createPtrToStackVar(offset);
-	emit("store i32 "+immidiate_or_reg+", i32* "+ptr);
+	//later loads of the variable in this basic block can use the stored value directly:
+	block_values[stackVarKey(offset)] = immidiate_or_reg;
+	return emit("store i32 "+immidiate_or_reg+", i32* "+ptr);
+}
+
+void CodeBuffer::emitReturn(const string& ir_typed_value){
+	int address = emit("ret " + ir_typed_value);
+	if(!current_func.empty())
+		func_sections[current_func].ret_addresses.push_back(address);
 }
 
 void CodeBuffer::emitFuncDecl(const string& id){
@@ -319,6 +1158,11 @@ void CodeBuffer::emitFuncDecl(const string& id){
 	}
 	string param_types = concatWithSpacing(ir_types, ", ");
 
+	block_values.clear();
+	current_func = id;
+	func_sections_order.push_back(id);
+	func_sections[id] = {.code_begin = (int)buffer.size(), .code_end = (int)buffer.size()
+		, .globals_begin = (int)globalDefs.size(), .globals_end = (int)globalDefs.size()};
 	emit("define "+ir_ret_type+"@"+id+"("+param_types+"){");
 }
 
@@ -338,14 +1182,71 @@ string CodeBuffer::IrDefaultTypedValue(ExpType type){
 	return "IML ERROR";
 }
 
+void CodeBuffer::emitStackAllocation(){
+	stack_reg = getFreshReg("sp");
+	stack_var_ptrs.clear();
+	stack_address = emit(stack_reg+" = alloca [50 x i32]");
+}
+
 string CodeBuffer::createPtrToStackVar(int offset){
-	std::string ptr_reg = getFreshReg();
-	emit(ptr_reg+" = getelementptr [50 x i32], [50 x i32]* %sp, i32 0, i32 "+std::to_string(offset));
-	return ptr_reg;
+	string ptr_rval = "getelementptr [50 x i32], [50 x i32]* "+stack_reg+", i32 0, i32 "+std::to_string(offset);
+	if(!compact_output)
+		return emitPureValue(ptr_rval);
+	//a pointer that is computed right after the allocation can be used anywhere in the function:
+	auto ptr = stack_var_ptrs.find(offset);
+	if(ptr == stack_var_ptrs.end()){
+		string ptr_reg = getFreshReg("var_ptr");
+		appendToCommand(stack_address, ptr_reg+" = "+ptr_rval);
+		ptr = stack_var_ptrs.insert({offset, ptr_reg}).first;
+	}
+	return ptr->second;
+}
+
+string CodeBuffer::stackVarKey(int offset){
+	return "load "+to_string(offset);
 }
 
-string CodeBuffer::getFreshReg(const string& reg_name){
-	return "%"+reg_name+to_string(reg_count++);
+string CodeBuffer::valueNumberingKey(const string& rvalue_exp){
+	//'add' and 'mul' are commutative, so their operands are sorted: "<op> <type> <first>, <second>"
+	if(rvalue_exp.compare(0, 4, "add ") != 0 && rvalue_exp.compare(0, 4, "mul ") != 0)
+		return rvalue_exp;
+	size_t first_begin = rvalue_exp.find(' ', 4) + 1;
+	size_t comma = rvalue_exp.find(", ", first_begin);
+	if(first_begin == 0 || comma == string::npos)
+		return rvalue_exp;
+	string first = rvalue_exp.substr(first_begin, comma - first_begin);
+	string second = rvalue_exp.substr(comma + 2);
+	if(second < first)
+		swap(first, second);
+	return rvalue_exp.substr(0, first_begin)+first+", "+second;
+}
+
+string CodeBuffer::emitPureValue(const string& rvalue_exp, const char* reg_name){
+	string key = valueNumberingKey(rvalue_exp);
+	auto known_value = block_values.find(key);
+	if(known_value != block_values.end())
+		return known_value->second;
+	string reg = getFreshReg(reg_name);
+	emit(reg+" = "+rvalue_exp);
+	block_values[key] = reg;
+	return reg;
+}
+
+string CodeBuffer::emitLoadStackVar(int offset){
+	//calls never change the stack of the caller (it is not passed to them), so only stores invalidate loaded values.
+	string key = stackVarKey(offset);
+	auto known_value = block_values.find(key);
+	if(known_value != block_values.end())
+		return known_value->second;
+	string ptr = createPtrToStackVar(offset);
+	string reg = getFreshReg("param_raw");
+	emit(reg+" = load i32, i32* "+ptr);
+	block_values[key] = reg;
+	return reg;
+}
+
+string CodeBuffer::getFreshReg(const char* reg_name){
+	return nameRef(newName(reg_name));
 }
 
 string CodeBuffer::IrType(ExpType type){
@@ -368,6 +1269,116 @@ string CodeBuffer::literalRvalFormat(int value, ExpType type){
 	return "add "+IrType(type)+" 0, "+to_string(value);
 }
 
+//returns k if 'value' is 2^k, otherwise -1.
+static int log2Exact(long long value){
+	if(value <= 0 || (value & (value - 1)) != 0)
+		return -1;
+	int k = 0;
+	while((1LL << k) < value)
+		++k;
+	return k;
+}
+
+/**
+ * @brief finds a multiplier and a shift such that for every value 'n' of 'num_bits' bits (not including the sign bit):
+ * 		floor(n * multiplier / 2^shift) = floor(n / divisor). 'divisor' should be at least 2 and not a power of two.
+ * 		for a negative 'n' the quotient rounded towards zero is 'floor(n * multiplier / 2^shift) + 1'.
+ **/
+static void divisionMagic(long long divisor, int num_bits, long long& multiplier, int& shift){
+	for(shift = num_bits; ; ++shift){
+		long long error = divisor - (long long)((1ULL << shift) % divisor);
+		if(error <= (1LL << (shift - num_bits))){
+			multiplier = (long long)((1ULL << shift) / divisor) + 1;
+			return;
+		}
+	}
+}
+
+string CodeBuffer::emitBinop(const string& first, const string& second, ExpType type, Binop binop){
+	assert(type == INT_EXP || type == BYTE_EXP);
+	const string ir_type = IrType(type);
+	const bool first_is_literal = isIntLiteral(first);
+	const bool second_is_literal = isIntLiteral(second);
+
+	//both are constants - the result is computed with the same wraparound as in runtime:
+	string folded;
+	if(first_is_literal && second_is_literal && foldConstantRvalue(binopRvalFormat(first, second, type, binop), folded))
+		return folded;
+
+	//identities:
+	const string& var = first_is_literal ? second : first;
+	const string& constant = first_is_literal ? first : second;
+	const bool one_literal = first_is_literal != second_is_literal;
+	const long long constant_value = one_literal ? stoll(constant) : 0;
+	switch(binop){
+	case PLUS:
+		if(one_literal && constant_value == 0)
+			return var;
+		break;
+	case MINUS:
+		if(second_is_literal && !first_is_literal && constant_value == 0)
+			return first;
+		if(!first_is_literal && first == second)
+			return "0";
+		break;
+	case MULT:
+		if(one_literal && constant_value == 0)
+			return "0";
+		if(one_literal && constant_value == 1)
+			return var;
+		break;
+	case DIV:
+		if(second_is_literal && !first_is_literal && constant_value == 1)
+			return first;
+		//the zero check was already done, so the division is not reached when both are zero:
+		if(!first_is_literal && first == second)
+			return "1";
+		break;
+	}
+
+	//strength reduction of multiplications and divisions by constants:
+	const int num_bits = (type == BYTE_EXP ? 8 : 32);
+	if(binop == MULT && one_literal){
+		int k = log2Exact(type == BYTE_EXP ? (uint8_t)constant_value : constant_value);
+		if(k > 0 && k < num_bits)
+			return emitPureValue("shl "+ir_type+" "+var+", "+to_string(k));
+	}
+	if(binop == DIV && second_is_literal && !first_is_literal){
+		long long divisor = (type == BYTE_EXP ? (uint8_t)constant_value : constant_value);
+		int k = log2Exact(divisor);
+		if(type == BYTE_EXP && k > 0)
+			return emitPureValue("lshr i8 "+first+", "+to_string(k));
+		if(type == BYTE_EXP && divisor > 1){
+			long long multiplier;
+			int shift;
+			divisionMagic(divisor, 8, multiplier, shift);
+			string wide = emitPureValue("zext i8 "+first+" to i32", "div_reg");
+			string product = emitPureValue("mul i32 "+wide+", "+to_string(multiplier), "div_reg");
+			string quotient = emitPureValue("lshr i32 "+product+", "+to_string(shift), "div_reg");
+			return emitPureValue("trunc i32 "+quotient+" to i8");
+		}
+		if(type == INT_EXP && k > 0 && k < 31){
+			//a negative dividend is rounded towards zero by adding 2^k - 1 to it before shifting:
+			string sign = emitPureValue("ashr i32 "+first+", 31", "div_reg");
+			string bias = emitPureValue("lshr i32 "+sign+", "+to_string(32 - k), "div_reg");
+			string biased = emitPureValue("add i32 "+first+", "+bias, "div_reg");
+			return emitPureValue("ashr i32 "+biased+", "+to_string(k));
+		}
+		if(type == INT_EXP && divisor > 1 && k == -1 && divisor <= INT32_MAX){
+			long long multiplier;
+			int shift;
+			divisionMagic(divisor, 31, multiplier, shift);
+			string wide = emitPureValue("sext i32 "+first+" to i64", "div_reg");
+			string product = emitPureValue("mul i64 "+wide+", "+to_string(multiplier), "div_reg");
+			string shifted = emitPureValue("ashr i64 "+product+", "+to_string(shift), "div_reg");
+			string floor_quotient = emitPureValue("trunc i64 "+shifted+" to i32", "div_reg");
+			string is_negative = emitPureValue("lshr i32 "+first+", 31", "div_reg");
+			return emitPureValue("add i32 "+floor_quotient+", "+is_negative);
+		}
+	}
+	return emitPureValue(binopRvalFormat(first, second, type, binop));
+}
+
 string CodeBuffer::binopRvalFormat(const string& first_reg, const string& second_reg, ExpType type, Binop binop){
 	assert(type == INT_EXP || type == BYTE_EXP);
 
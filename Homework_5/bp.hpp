@@ -3,27 +3,62 @@
 
 #include <vector>
 #include <string>
+#include <set>
+#include <unordered_map>
 #include "AuxTypes.hpp"
 
 using namespace std;
 
+#ifdef LLVM_BACKEND
+class ModuleBuilder;
+#endif
+
 class CodeBuffer{
 	CodeBuffer();
 	CodeBuffer(CodeBuffer const&);
     void operator=(CodeBuffer const&);
 	std::vector<std::string> buffer;
 	std::vector<std::string> globalDefs;
+	//registers and labels are numbered together, so every name of a function is unique.
+	//the debug name of each number, and the location of each label (-1 for a register):
+	std::vector<const char*> name_hints;
+	std::vector<int> label_addresses;
 public:
 	static CodeBuffer &instance();
 
 	// ******** Methods to handle the code section ******** //
 
 	//generates a jump location label for the next command, writes it to the buffer and returns it
-	std::string genLabel(const string& label_name = "label");
+	Label genLabel(const char* label_name = "label");
+	/**
+	 * @brief returns a new number for a register or a label, that will be printed as '<hint><number>'.
+	 * 		note - 'hint' should be a string literal that does not end with a digit.
+	 */
+	int newName(const char* hint);
+	//the way a numbered register or label is written in a command, e.g. '$12'. it is replaced with its name when printed:
+	static std::string nameRef(int name);
 
 	//writes command to the buffer, returns its location in the buffer
 	int emit(const std::string &command);
 
+	//returns the location in the buffer that the next command will be written to
+	int getNextAddress() const;
+	//returns the location in the buffer of a label that was generated by 'genLabel'
+	int labelAddress(Label label) const;
+	const std::string& commandAt(int address) const;
+	void replaceCommand(int address, const std::string& command);
+	//adds more commands right after the command at 'address', they will be printed as part of the same buffer entry.
+	void appendToCommand(int address, const std::string& commands);
+
+	/**
+	 * @brief writes a copy of the commands in the range [begin, end) to the end of the buffer.
+	 * 		every register and label that is defined inside the range gets a new number in the copy,
+	 * 		which is added to 'renames' under the old number.
+	 * 		missing labels ('@') are copied as is, so a backpatch address 'a' of the range is at 'a - begin + <returned value>' in the copy.
+	 * @return the location in the buffer of the first copied command.
+	 */
+	int cloneCode(int begin, int end, std::unordered_map<int, int>& renames);
+
 	//gets a pair<int,BranchLabelIndex> item of the form {buffer_location, branch_label_index} and creates a list for it
 	static vector<Backpatch> makelist(pair<int,BranchLabelIndex> item);
 	static vector<Backpatch> makeEmptyList();
@@ -38,54 +73,212 @@ public:
 	note - for unconditional branches (which contain only a single label) use FIRST as the branch_label_index.
 	example #1:
 	int loc1 = emit("br label @");  - unconditional branch missing a label. ~ Note the '@' ~
-	bpatch(makelist({loc1,FIRST}),"my_label"); - location loc1 in the buffer will now contain the command "br label %my_label"
+	bpatch(makelist({loc1,FIRST}),my_label); - location loc1 in the buffer will now contain the command "br label $<my_label>"
 	note that index FIRST referes to the one and only label in the line.
 	example #2:
-	int loc2 = emit("br i1 %cond, label @, label @"); - conditional branch missing two labels.
-	bpatch(makelist({loc2,SECOND}),"my_false_label"); - location loc2 in the buffer will now contain the command "br i1 %cond, label @, label %my_false_label"
-	bpatch(makelist({loc2,FIRST}),"my_true_label"); - location loc2 in the buffer will now contain the command "br i1 %cond, label @my_true_label, label %my_false_label"
+	int loc2 = emit("br i1 "+cond+", label @, label @"); - conditional branch missing two labels.
+	bpatch(makelist({loc2,SECOND}),false_label); - location loc2 in the buffer will now contain the command "br i1 <cond>, label @, label $<false_label>"
+	bpatch(makelist({loc2,FIRST}),true_label); - location loc2 in the buffer will now contain the command "br i1 <cond>, label $<true_label>, label $<false_label>"
 	*/
-	void bpatch(const vector<Backpatch>& address_list, const std::string &label);
+	void bpatch(const vector<Backpatch>& address_list, Label label);
+
+	/**
+	 * @brief replaces the (already emitted) branch command at 'address' with a switch over 'value_reg'.
+	 * @param cases - pairs of {constant, label}. if a constant appears more than once, only its first label is used.
+	 * @param default_label - if NO_LABEL, the default label is left as '@' and should be backpatched
+	 * 		using Backpatch(address, FIRST).
+	 */
+	void rewriteAsSwitch(int address, const string& value_reg, ExpType type
+		, const vector<pair<string, Label>>& cases, Label default_label);
 	
-	//prints the content of the code buffer to stdout
+	//prints the content of the code buffer to stdout, this is where the numbered names are given their text.
 	void printCodeBuffer();
+	/**
+	 * @brief makes the printed module as small as possible: the registers and labels of every function get the shortest
+	 * 		names in the order they are printed, spaces that llvm does not need are dropped, and the pointer to each
+	 * 		stack variable is computed only once, at the start of the function.
+	 * 		note - this should be called before any code is emitted.
+	 */
+	void setCompactOutput(bool compact);
 
 	// ******** Methods to handle the data section ******** //
 	//write a line to the global section
 	void emitGlobal(const string& dataLine);
 	//print the content of the global buffer to stdout
 	void printGlobalBuffer();
+	/**
+	 * @brief returns the id of a global constant that holds 'value' (without the quotation marks).
+	 * 		every distinct string is defined only once, and is shared by all of the places that use it.
+	 */
+	string getStringConstant(const string& value);
+
+	// ******** Methods to handle the call graph ******** //
+	//marks the end of the function that was started by the last call to 'emitFuncDecl'.
+	void emitFuncEnd();
+	/**
+	 * @brief removes from both buffers every function (and the globals it defined) that can not be reached
+	 * 		by a chain of calls from 'root_func_id'. library functions that are not reachable will not be emitted by 'emitLibFuncs'.
+	 * 		note - this should only be called after all of the code was emitted and backpatched.
+	 */
+	void removeUnreachableFuncs(const string& root_func_id);
+	/**
+	 * @return true if the function calls itself, returns an int/byte/bool computed only from its (non empty) parameters,
+	 * 		and does not print (directly or through the functions it calls).
+	 **/
+	bool isMemoizable(const string& func_id) const;
+	/**
+	 * @brief adds a lookup in a bounded memo table of the currently parsed function right before the command at 'entry_address',
+	 * 		and a store to that table before each of its returns. this should be called before 'emitFuncEnd'.
+	 * @param entry_address - the address of the first branch of the function (to the first statement).
+	 */
+	void emitMemoization(const string& func_id, int entry_address);
+	/**
+	 * @brief creates copies of functions in which some of the parameters are replaced by constants,
+	 * 		for the combinations of constant arguments that are passed most often, and redirects the matching calls to them.
+	 * 		the constants are folded in the copies, so the branches they decide and the code only those branches reach are removed.
+	 * 		note - this should only be called after all of the code was emitted and backpatched.
+	 * @param max_clones - the maximal number of copies to create (over all of the functions).
+	 * @return the number of copies that were created.
+	 */
+	int specializeFuncs(int max_clones);
 
 	// ******** Methods to produce LLVM IR ******** //
-	void emitLibFuncs();
+	/**
+	 * @brief emits the library functions (and the globals they use), only the reachable ones if 'removeUnreachableFuncs' was called.
+	 * @param declarations_only - emit only declarations, for linking against the module printed by 'printLibModule'.
+	 */
+	void emitLibFuncs(bool declarations_only = false);
+	//prints all of the library functions as a module of their own.
+	static void printLibModule();
+#ifdef LLVM_BACKEND
+	/**
+	 * @brief writes the module to stdout as llvm bitcode instead of printing the buffers, see bitcode.cpp.
+	 * 		the library functions are added by this function, so 'emitLibFuncs' should not be called.
+	 * 		note - this should only be called after all of the code was emitted and backpatched.
+	 */
+	void printBitcode(bool lib_declarations_only = false);
+	/**
+	 * @brief compiles the module with llvm's ORC JIT and runs 'main' in this process, see bitcode.cpp.
+	 * 		the library functions are bound to native functions, so 'emitLibFuncs' should not be called.
+	 * 		note - this should only be called after all of the code was emitted and backpatched.
+	 */
+	void runMain();
+#endif
+	/**
+	 * @brief compiles the buffers to bytecode and runs 'main' with the interpreter of vm.cpp, which does not need llvm.
+	 * 		the library functions are part of the interpreter, so 'emitLibFuncs' should not be called.
+	 * 		note - this should only be called after all of the code was emitted and backpatched.
+	 */
+	void runBytecode();
 	
 	/**
 	 * @brief creates a new register and assigns it the value of 'src_reg_type'.
-	 * @param src_reg_type - either a name of a register in the form of '%reg' or an immidiate value like '3'.
-	 * @param new_reg_prefix - the prefix to the name of the newly created register.
-	 * @return the name of the newly created register.
+	 * @param src_reg_type - either a register in the form of '$12' or an immidiate value like '3'.
+	 * @param new_reg_prefix - the debug name hint of the newly created register.
+	 * @return the newly created register.
 	 **/
-	string emitCopyReg(const string& src_reg_or_imm, ExpType src_reg_type, const string& new_reg_prefix = "copy");
+	string emitCopyReg(const string& src_reg_or_imm, ExpType src_reg_type, const char* new_reg_prefix = "copy");
 	//string emitRegDecl(const string& lvalue_id, const string& rvalue_exp); 
-	void emitStoreVar(const string& id, Expression* exp_to_assign);
-	void emitStoreVar(const string& id, const string& reg_or_immidiate);
+	//both versions of emitStoreVar return the location of the store command in the buffer.
+	int emitStoreVar(const string& id, Expression* exp_to_assign);
+	int emitStoreVar(const string& id, const string& reg_or_immidiate);
 	void emitFuncDecl(const string& id);
+	//emits a return command of the currently parsed function, 'ir_typed_value' is something like 'i32 %reg' or 'void'.
+	void emitReturn(const string& ir_typed_value);
 	Expression* emitFunctionCall(const string& func_id, const vector<Expression*>& param_expressions);
 	Expression* emitLoadVar(const string& id);
 	Expression* createIdentifiableFromReg(const string& reg_name, ExpType type, bool rvalue_reg_is_raw_data);
 	
+	//emits the stack of the currently parsed function, this should be the first command of its body.
+	void emitStackAllocation();
 	string createPtrToStackVar(int offset);
-	string getFreshReg(const string& reg_name = "reg");
+	/**
+	 * @brief emits 'reg = rvalue_exp' for an rvalue without side effects (arithmetic, icmp, casts, getelementptr),
+	 * 		unless the same rvalue was already computed in the current basic block.
+	 * @return the register holding the value.
+	 **/
+	string emitPureValue(const string& rvalue_exp, const char* reg_name = "reg");
+	//returns a register (or an immidiate) holding the raw value of the local variable at 'offset'.
+	string emitLoadStackVar(int offset);
+	//returns a reference to a new register, see 'nameRef':
+	string getFreshReg(const char* reg_name = "reg");
 	string IrDefaultTypedValue(ExpType type);
 	string IrType(ExpType type);
 	string IrRelopType(Relop rel_type, ExpType type);
 	string IrFuncTypeFormat(const string& func_id);
 	string relopRvalFormat(const string& first_reg, const string& second_reg, ExpType type, Relop relop);
 	string binopRvalFormat(const string& first_reg, const string& second_reg, ExpType type, Binop binop);
+	/**
+	 * @brief emits 'first binop second' for two raw values of 'type' (registers or immidiates). constants are folded,
+	 * 		identities like 'x + 0' or 'x - x' are dropped, and multiplications and divisions by constants are replaced
+	 * 		with shifts and multiplications that give exactly the same (wrapped around) results.
+	 * 		note - a division is expected to be emitted after the check for a zero divisor.
+	 * @return a register or an immidiate holding the result.
+	 **/
+	string emitBinop(const string& first, const string& second, ExpType type, Binop binop);
 	string literalRvalFormat(int value, ExpType type);
 private:
-	int reg_count = 1;
-	void emitStoreVarBasic(const string& id, const string& immidiate_or_reg);
+	//writes 'command' to 'out' with the name of every '$<number>' in it:
+	void printCommand(const string& command, string& out);
+
+	bool compact_output = false;
+	//the stack of the currently parsed function, and the location of its allocation in the buffer:
+	std::string stack_reg;
+	int stack_address;
+	//with compact output, the pointers to the stack variables of the currently parsed function by their offsets:
+	std::unordered_map<int, std::string> stack_var_ptrs;
+	//with compact output, the names are numbered again for every printed function, in the order they first appear:
+	std::vector<int> printed_names;
+	std::vector<int> printed_names_func;
+	int printed_func = 0;
+	int printed_names_count = 0;
+	void appendCompactName(int name, string& out);
+#ifdef LLVM_BACKEND
+	void fillModule(ModuleBuilder& module, bool lib_declarations_only);
+#endif
+	int emitStoreVarBasic(const string& id, const string& immidiate_or_reg);
+
+	//local value numbering - maps each value computed in the current basic block to the register holding it.
+	//loaded stack variables are kept under the key returned by 'stackVarKey'.
+	std::unordered_map<std::string, std::string> block_values;
+	static std::string stackVarKey(int offset);
+	static std::string valueNumberingKey(const std::string& rvalue_exp);
+
+	//the part of the buffers that was emitted while parsing a single function, and the functions it calls:
+	struct FuncSection{
+		int code_begin = 0;
+		int code_end = 0;
+		int globals_begin = 0;
+		int globals_end = 0;
+		std::set<std::string> callees = {};
+		std::vector<int> ret_addresses = {};
+		bool is_pure = false;
+		//the function this section is a specialized copy of (empty for a parsed function):
+		std::string origin = {};
+		//the ids of the string constants used by the function:
+		std::set<std::string> strings = {};
+	};
+	//the string constants by their content, and their definitions in the order they were created:
+	std::unordered_map<std::string, std::string> string_ids;
+	std::vector<std::pair<std::string, std::string>> string_defs;
+	std::set<std::string> reachable_strings;
+	//a call with its arguments as typed raw values (like 'i32 %reg' or 'i32 3'):
+	struct CallSite{
+		int address;
+		std::string caller;
+		std::string callee;
+		std::vector<std::string> args;
+	};
+	std::vector<CallSite> call_sites;
+	std::vector<std::string> func_sections_order;
+	std::unordered_map<std::string, FuncSection> func_sections;
+	std::string current_func;
+	bool reachability_known = false;
+	std::set<std::string> reachable_funcs;
+	bool isLibFuncUsed(const string& func_id) const;
+	bool isPureFunc(const string& func_id) const;
+	bool calleesArePure(const string& func_id) const;
+	static const int MEMO_TABLE_SIZE = 4096;
 };
 
 #endif
@@ -0,0 +1,485 @@
+//a hand written scanner for FanC, used instead of scanner.lex when building with 'make LEXER=hand'.
+//it provides the same interface to the parser (yylex, yylval, yylineno, scanInputFile, scanStdin, lexInParallel, rescanInput),
+//and returns exactly the same tokens as the flex scanner.
+#ifdef HAND_LEXER
+
+#include "hw3_output.hpp"
+#include "Symtab.hpp"
+#include "parser.tab.hpp"
+#include <iostream>
+#include <iterator>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
+
+int yylineno = 1;
+
+// ******** Keywords ******** //
+
+struct Keyword{
+	const char* text;
+	int length;
+	int token;
+};
+static const Keyword KEYWORDS[] = {
+	{"void", 4, VOID}, {"int", 3, INT}, {"byte", 4, BYTE}, {"b", 1, B}, {"bool", 4, BOOL}, {"const", 5, CONST},
+	{"and", 3, AND}, {"or", 2, OR}, {"not", 3, NOT}, {"true", 4, TRUE}, {"false", 5, FALSE}, {"return", 6, RETURN},
+	{"if", 2, IF}, {"else", 4, ELSE}, {"while", 5, WHILE}, {"break", 5, BREAK}, {"continue", 8, CONTINUE}
+};
+static const int NUM_KEYWORDS = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+static const int KEYWORD_TABLE_SIZE = 32;
+
+//a perfect hash of the keywords - every keyword has a slot of its own in a table of 'KEYWORD_TABLE_SIZE' entries.
+static constexpr int keywordHash(const char* word, int length){
+	return (length + word[0] * 13 + word[length - 1] * 2) & (KEYWORD_TABLE_SIZE - 1);
+}
+
+struct KeywordTable{
+	//the index in 'KEYWORDS' of the keyword in each slot, or -1 for an empty slot:
+	int slots[KEYWORD_TABLE_SIZE];
+	bool is_perfect;
+	constexpr KeywordTable()
+		:slots(), is_perfect(true){
+		for(int slot = 0; slot < KEYWORD_TABLE_SIZE; ++slot)
+			slots[slot] = -1;
+		for(int i = 0; i < NUM_KEYWORDS; ++i){
+			int slot = keywordHash(KEYWORDS[i].text, KEYWORDS[i].length);
+			if(slots[slot] != -1)
+				is_perfect = false;
+			slots[slot] = i;
+		}
+	}
+};
+static constexpr KeywordTable KEYWORD_TABLE;
+static_assert(KEYWORD_TABLE.is_perfect, "two keywords have the same hash");
+
+//returns the token of the keyword 'word', or ID if it is not a keyword.
+static int keywordOrId(const char* word, int length){
+	int index = KEYWORD_TABLE.slots[keywordHash(word, length)];
+	if(index != -1 && KEYWORDS[index].length == length && memcmp(KEYWORDS[index].text, word, length) == 0)
+		return KEYWORDS[index].token;
+	return ID;
+}
+
+// ******** Scanning ******** //
+
+//the scanning position in a part of the input. the part always ends with a new line, or with two '\0' chars.
+struct Scanner{
+	const char* cursor;
+	const char* end;
+	//the number of the current line:
+	int line;
+};
+
+//the scanner of the whole input, used by yylex unless the input was scanned in advance:
+static Scanner main_scanner;
+
+//the token returned by 'scanToken' for text that is not matched by any rule:
+static const int LEX_ERROR = -1;
+
+static inline bool isWhitespace(char c){
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+static inline bool isLetter(char c){
+	return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+}
+static inline bool isDigit(char c){
+	return '0' <= c && c <= '9';
+}
+
+//skips the whitespace at the cursor, counting the new lines.
+static void skipWhitespace(Scanner& scanner){
+	const char*& cursor = scanner.cursor;
+#ifdef __SSE2__
+	//16 chars are checked at a time, as long as they are all before the end of the input:
+	const __m128i spaces = _mm_set1_epi8(' '), tabs = _mm_set1_epi8('\t');
+	const __m128i new_lines = _mm_set1_epi8('\n'), carriage_returns = _mm_set1_epi8('\r');
+	while(scanner.end - cursor >= 16){
+		__m128i chars = _mm_loadu_si128((const __m128i*)cursor);
+		__m128i is_new_line = _mm_cmpeq_epi8(chars, new_lines);
+		__m128i is_whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, spaces), _mm_cmpeq_epi8(chars, tabs))
+			, _mm_or_si128(is_new_line, _mm_cmpeq_epi8(chars, carriage_returns)));
+		unsigned non_whitespace_mask = ~_mm_movemask_epi8(is_whitespace) & 0xFFFF;
+		unsigned new_line_mask = _mm_movemask_epi8(is_new_line);
+		if(non_whitespace_mask == 0){
+			scanner.line += __builtin_popcount(new_line_mask);
+			cursor += 16;
+			continue;
+		}
+		int whitespace_length = __builtin_ctz(non_whitespace_mask);
+		scanner.line += __builtin_popcount(new_line_mask & ((1u << whitespace_length) - 1));
+		cursor += whitespace_length;
+		return;
+	}
+#endif
+	while(cursor < scanner.end && isWhitespace(*cursor)){
+		scanner.line += (*cursor == '\n');
+		++cursor;
+	}
+}
+
+//returns the first '\n' or '\r' in [from, end), or 'end' if there is none.
+static const char* findLineEnd(const char* from, const char* end){
+#ifdef __SSE2__
+	const __m128i new_lines = _mm_set1_epi8('\n'), carriage_returns = _mm_set1_epi8('\r');
+	while(end - from >= 16){
+		__m128i chars = _mm_loadu_si128((const __m128i*)from);
+		unsigned line_end_mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chars, new_lines)
+			, _mm_cmpeq_epi8(chars, carriage_returns)));
+		if(line_end_mask != 0)
+			return from + __builtin_ctz(line_end_mask);
+		from += 16;
+	}
+#endif
+	while(from < end && *from != '\n' && *from != '\r')
+		++from;
+	return from;
+}
+
+//skips a comment that starts at the cursor and returns true, unless the comment is not ended by a new line.
+//(such a comment is not matched by the comment rule of scanner.lex, so it is scanned as '/' tokens)
+static bool skipComment(Scanner& scanner){
+	const char* line_end = findLineEnd(scanner.cursor + 2, scanner.end);
+	if(line_end == scanner.end)
+		return false;
+	if(*line_end == '\r' && line_end + 1 < scanner.end && line_end[1] == '\n')
+		++line_end;
+	scanner.line += (*line_end == '\n');
+	scanner.cursor = line_end + 1;
+	return true;
+}
+
+//returns the length of the string literal that starts at 'begin', or 0 if it does not match the string pattern.
+static int stringLiteralLength(const char* begin, const char* input_end){
+	const char* end = begin + 1;
+	while(end < input_end){
+		char c = *end;
+		if(c == '"')
+			return end - begin > 1 ? end + 1 - begin : 0;
+		if(c == '\n' || c == '\r')
+			return 0;
+		if(c == '\\'){
+			char escaped = end + 1 < input_end ? end[1] : '\0';
+			if(escaped != 'r' && escaped != 'n' && escaped != 't' && escaped != '"' && escaped != '\\')
+				return 0;
+			++end;
+		}
+		++end;
+	}
+	return 0;
+}
+
+//converts a number the same way atoi does (a value that does not fit in a long is clamped to LONG_MAX).
+static int numberValue(const char* digits, int length){
+	unsigned long long value = 0;
+	for(int i = 0; i < length; ++i){
+		value = value * 10 + (digits[i] - '0');
+		if(value > (unsigned long long)LONG_MAX)
+			return (int)LONG_MAX;
+	}
+	return (int)(long)value;
+}
+
+/**
+ * @brief scans the next token, and sets its semantic value (if it has one) in 'value'.
+ * @return the token, 0 at the end of the scanned part or LEX_ERROR. after an error the cursor is left at the unmatched char.
+ **/
+static int scanToken(Scanner& scanner, YYSTYPE& value){
+	while(true){
+		skipWhitespace(scanner);
+		if(scanner.cursor >= scanner.end)
+			return 0;
+		if(scanner.cursor[0] == '/' && scanner.cursor[1] == '/' && skipComment(scanner))
+			continue;
+		break;
+	}
+
+	const char*& cursor = scanner.cursor;
+	const char* begin = cursor;
+	char c = *cursor++;
+	if(isLetter(c)){
+		while(isLetter(*cursor) || isDigit(*cursor))
+			++cursor;
+		int length = cursor - begin;
+		int token = keywordOrId(begin, length);
+		if(token == ID)
+			value.id = {.begin = begin, .length = length};
+		return token;
+	}
+	if(isDigit(c)){
+		//a number never starts with a leading zero, so "01" is two numbers:
+		if(c != '0'){
+			while(isDigit(*cursor))
+				++cursor;
+		}
+		value.number_literal = numberValue(begin, cursor - begin);
+		return NUM;
+	}
+	switch(c){
+	case ';': return SC;
+	case ',': return COMMA;
+	case '(': return LPAREN;
+	case ')': return RPAREN;
+	case '{': return LBRACE;
+	case '}': return RBRACE;
+	case '=':
+		if(*cursor != '=')
+			return ASSIGN;
+		++cursor;
+		value.relop = EQUAL;
+		return RELOP;
+	case '!':
+		if(*cursor != '=')
+			break;
+		++cursor;
+		value.relop = NOT_EQUAL;
+		return RELOP;
+	case '<':
+	case '>': {
+		bool or_equal = (*cursor == '=');
+		cursor += or_equal;
+		if(c == '<')
+			value.relop = or_equal ? LESS_EQUAL : LESS;
+		else
+			value.relop = or_equal ? GREATER_EQUAL : GREATER;
+		return RELOP;
+	}
+	case '*':
+		value.binop = MULT;
+		return HIGH_PRIO_BINOP;
+	case '/':
+		value.binop = DIV;
+		return HIGH_PRIO_BINOP;
+	case '+':
+		value.binop = PLUS;
+		return LOW_PRIO_BINOP;
+	case '-':
+		value.binop = MINUS;
+		return LOW_PRIO_BINOP;
+	case '"': {
+		int length = stringLiteralLength(begin, scanner.end);
+		if(length == 0)
+			break;
+		cursor = begin + length;
+		value.string_literal = {.begin = begin, .length = length};
+		return STRING;
+	}
+	}
+	cursor = begin;
+	return LEX_ERROR;
+}
+
+// ******** Parallel scanning ******** //
+
+//the smallest part of the input that is worth scanning in a thread of its own:
+static const size_t MIN_PART_SIZE = 1 << 20;
+
+//a token that was scanned in advance. the text of an ID or a STRING is kept as 'begin' and 'length',
+//the value of any other token that has one is kept in 'length'.
+struct ScannedToken{
+	int token;
+	int line;
+	const char* begin;
+	int length;
+};
+
+//the parts of the input that were scanned in advance by 'lexInParallel', in the order of the input:
+static vector<vector<ScannedToken>> scanned_parts;
+static size_t next_part = 0, next_token = 0;
+static bool replaying_scanned_tokens = false;
+//the number of the line at the end of the input:
+static int last_line;
+
+//scans a part of the input, counting its lines from 0, until its end or until the first error.
+static void scanPart(Scanner scanner, vector<ScannedToken>& tokens, int& num_lines){
+	//typical code has a token for every 4-5 chars:
+	tokens.reserve((scanner.end - scanner.cursor) / 4);
+	YYSTYPE value;
+	while(true){
+		int token = scanToken(scanner, value);
+		if(token == 0)
+			break;
+		ScannedToken scanned = {.token = token, .line = scanner.line, .begin = nullptr, .length = 0};
+		switch(token){
+		case ID:
+			scanned.begin = value.id.begin;
+			scanned.length = value.id.length;
+			break;
+		case STRING:
+			scanned.begin = value.string_literal.begin;
+			scanned.length = value.string_literal.length;
+			break;
+		case NUM:
+			scanned.length = value.number_literal;
+			break;
+		case RELOP:
+			scanned.length = value.relop;
+			break;
+		case HIGH_PRIO_BINOP:
+		case LOW_PRIO_BINOP:
+			scanned.length = value.binop;
+			break;
+		}
+		tokens.push_back(scanned);
+		if(token == LEX_ERROR)
+			break;
+	}
+	num_lines = scanner.line;
+}
+
+bool lexInParallel(int num_threads){
+	const char* begin = main_scanner.cursor;
+	const size_t size = main_scanner.end - begin;
+	int num_parts = (int)min<size_t>(num_threads, size / MIN_PART_SIZE);
+	if(num_parts < 2)
+		return false;
+
+	//every part but the last ends right after a '\n', and no token or comment spans over a '\n':
+	vector<const char*> part_begins = {begin};
+	for(int part = 1; part < num_parts; ++part){
+		const char* split = max(part_begins.back(), begin + size * part / num_parts);
+		const char* new_line = (const char*)memchr(split, '\n', main_scanner.end - split);
+		if(!new_line)
+			break;
+		part_begins.push_back(new_line + 1);
+	}
+	part_begins.push_back(main_scanner.end);
+	num_parts = part_begins.size() - 1;
+
+	scanned_parts.assign(num_parts, {});
+	vector<int> part_lines(num_parts);
+	vector<thread> workers;
+	for(int part = 0; part < num_parts; ++part){
+		Scanner part_scanner = {.cursor = part_begins[part], .end = part_begins[part + 1], .line = 0};
+		workers.emplace_back(scanPart, part_scanner, ref(scanned_parts[part]), ref(part_lines[part]));
+	}
+	for(thread& worker: workers)
+		worker.join();
+
+	//the line numbers are counted from the start of each part:
+	int first_line = main_scanner.line;
+	for(int part = 0; part < num_parts; ++part){
+		for(ScannedToken& token: scanned_parts[part])
+			token.line += first_line;
+		first_line += part_lines[part];
+	}
+	last_line = first_line;
+	replaying_scanned_tokens = true;
+	next_part = next_token = 0;
+	return true;
+}
+
+// ******** yylex ******** //
+
+static int lexError(){
+	reportEarlierErrors();
+	output::errorLex(yylineno);
+	exit(420);
+}
+
+//returns the next token that was scanned in advance by 'lexInParallel'.
+static int nextScannedToken(){
+	while(next_part < scanned_parts.size() && next_token == scanned_parts[next_part].size()){
+		++next_part;
+		next_token = 0;
+	}
+	if(next_part == scanned_parts.size()){
+		yylineno = last_line;
+		return 0;
+	}
+	const ScannedToken& scanned = scanned_parts[next_part][next_token++];
+	yylineno = scanned.line;
+	switch(scanned.token){
+	case ID:
+		yylval.id = {.begin = scanned.begin, .length = scanned.length};
+		break;
+	case STRING:
+		yylval.string_literal = {.begin = scanned.begin, .length = scanned.length};
+		break;
+	case NUM:
+		yylval.number_literal = scanned.length;
+		break;
+	case RELOP:
+		yylval.relop = (Relop)scanned.length;
+		break;
+	case HIGH_PRIO_BINOP:
+	case LOW_PRIO_BINOP:
+		yylval.binop = (Binop)scanned.length;
+		break;
+	}
+	return scanned.token;
+}
+
+int yylex(){
+	int token;
+	if(replaying_scanned_tokens){
+		token = nextScannedToken();
+	} else {
+		token = scanToken(main_scanner, yylval);
+		yylineno = main_scanner.line;
+	}
+	if(token == LEX_ERROR)
+		return lexError();
+	return token;
+}
+
+// ******** Input ******** //
+
+//the scanner at the start of the input:
+static Scanner input_start;
+
+//the input is followed by two '\0' chars, just like the buffers flex scans in place.
+static void scanInPlace(const char* buffer, size_t size){
+	main_scanner = input_start = {.cursor = buffer, .end = buffer + size, .line = 1};
+	yylineno = 1;
+}
+
+//the tokens that were scanned in advance are returned again from the first one:
+void rescanInput(){
+	main_scanner = input_start;
+	next_part = next_token = 0;
+	yylineno = 1;
+}
+
+bool scanInputFile(const char* path){
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return false;
+	struct stat file_stat;
+	if(fstat(fd, &file_stat) != 0){
+		close(fd);
+		return false;
+	}
+	size_t size = file_stat.st_size;
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t mapping_size = (size + 2 + page_size - 1) / page_size * page_size;
+	//zeroed pages are reserved first so the two chars after the end of the file are mapped even when it fills its last page:
+	char* buffer = (char*)mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	bool mapped = buffer != MAP_FAILED;
+	if(mapped && size > 0)
+		mapped = mmap(buffer, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) != MAP_FAILED;
+	close(fd);
+	if(!mapped)
+		return false;
+	scanInPlace(buffer, size);
+	return true;
+}
+
+void scanStdin(){
+	static std::string input;
+	input.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+	size_t size = input.size();
+	input.resize(size + 2);
+	scanInPlace(input.data(), size);
+}
+
+#endif
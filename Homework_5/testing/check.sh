@@ -6,6 +6,8 @@ DEFAULT_TESTS_DIR='alex'
 
 VIEWING_PROGRAM='code'
 EXE='../hw5'
+# with VM=1 (e.g 'VM=1 ./check.sh alex') the tests are run by 'hw5 --vm' instead of being compiled and run by lli:
+VM=${VM:-0}
 
 RED='\033[0;31m'
 GREEN='\033[0;32m'
@@ -28,41 +30,63 @@ function check_test () {
 		printf "$TEST.in: ${BLUE} NOT FOUND ${NC}\n"
 	elif [ ! -f $TEST.exp ]; then
 		printf "$TEST.exp: ${BLUE} NOT FOUND ${NC}\n"
+	elif [ ! -f $TEST.flags ]; then
+		run_test ""
 	else
-		$EXE < $TEST.in > $TEST.llvm
+		# every line of $TEST.flags is a set of flags to run the test with:
+		mapfile -t FLAG_SETS < $TEST.flags
+		for FLAGS in "${FLAG_SETS[@]}"
+		do
+			run_test "$FLAGS"
+		done
+	fi
+}
+
+# runs $TEST with the flags in $1, and compares its output to $TEST.exp:
+function run_test () {
+	RUN_FLAGS=$1
+	if [ "$VM" == "1" ]; then
+		RUN_FLAGS="--vm${1:+ $1}"
+	fi
+	NAME=$TEST
+	if [ -n "$RUN_FLAGS" ]; then
+		NAME="$TEST ($RUN_FLAGS)"
+	fi
+	if [ "$VM" == "1" ]; then
+		$EXE $RUN_FLAGS < $TEST.in > $TEST.res
+	else
+		$EXE $RUN_FLAGS < $TEST.in > $TEST.llvm
 		lli $TEST.llvm > $TEST.res
-		LLI_RES=$?
-		diff $TEST.exp $TEST.res
-		if [ $? -eq 0 ]; then
-			printf "$TEST: ${GREEN} SUCCESS ${NC}\n"
-		else
-			printf "$TEST: ${RED} FAILURE ${NC}\n"
-			printf "\t${BLUE}< expected but not found${NC}\n"
-			printf "\t${BLUE}> found but not expected${NC}\n"
-			
-			printf "\n${YELLOW}what to do? [nothing<enter> | llvm<l> | input<i> | expected<e> | output<o> | gdb<g>]${NC}\n"
-			read SHOULD_CAT_OUTPUT
-			if [ -z $SHOULD_CAT_OUTPUT ]; then
-				exit 1
-			elif [ $SHOULD_CAT_OUTPUT == 'l' ]; then
-				$VIEWING_PROGRAM $TEST.llvm
-			elif [ $SHOULD_CAT_OUTPUT == 'i' ]; then
-				$VIEWING_PROGRAM $TEST.in
-			elif [ $SHOULD_CAT_OUTPUT == 'e' ]; then
-				$VIEWING_PROGRAM $TEST.exp
-			elif [ $SHOULD_CAT_OUTPUT == 'o' ]; then
-				$VIEWING_PROGRAM $TEST.res
-			elif [ $SHOULD_CAT_OUTPUT == 'g' ]; then
-				echo "run on gdb with 'run < \$TEST'"
-				export TEST="$TEST.in"
-				gdb $EXE
-			fi
+	fi
+	diff $TEST.exp $TEST.res
+	if [ $? -eq 0 ]; then
+		printf "$NAME: ${GREEN} SUCCESS ${NC}\n"
+	else
+		printf "$NAME: ${RED} FAILURE ${NC}\n"
+		printf "\t${BLUE}< expected but not found${NC}\n"
+		printf "\t${BLUE}> found but not expected${NC}\n"
+		
+		printf "\n${YELLOW}what to do? [nothing<enter> | llvm<l> | input<i> | expected<e> | output<o> | gdb<g>]${NC}\n"
+		read SHOULD_CAT_OUTPUT
+		if [ -z $SHOULD_CAT_OUTPUT ]; then
 			exit 1
+		elif [ $SHOULD_CAT_OUTPUT == 'l' ]; then
+			$VIEWING_PROGRAM $TEST.llvm
+		elif [ $SHOULD_CAT_OUTPUT == 'i' ]; then
+			$VIEWING_PROGRAM $TEST.in
+		elif [ $SHOULD_CAT_OUTPUT == 'e' ]; then
+			$VIEWING_PROGRAM $TEST.exp
+		elif [ $SHOULD_CAT_OUTPUT == 'o' ]; then
+			$VIEWING_PROGRAM $TEST.res
+		elif [ $SHOULD_CAT_OUTPUT == 'g' ]; then
+			echo "run on gdb with 'run $RUN_FLAGS < \$TEST'"
+			export TEST="$TEST.in"
+			gdb $EXE
 		fi
+		exit 1
 	fi
 }
 
-
 if [ -z $1 ]; then
 	TESTS_DIR=$DEFAULT_TESTS_DIR
 else
@@ -0,0 +1,53 @@
+# runs every program of the tests directories with 'hw5', and checks that 'hw5 --check-only' and 'hw5 --ast' report the same error.
+# a program without errors should pass the check without any output, and be compiled to the same code with the syntax tree.
+# usage: ./check_errors.sh [tests directories...]   (default: errors alex yosnkos)
+EXE='../hw5'
+WORK_DIR=$(mktemp -d)
+trap "rm -rf $WORK_DIR" EXIT
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+if [ ! -f $EXE ]; then
+	printf "${RED}Error: executable: '${EXE}'  -  not found! ${NC}\n"
+	exit 1
+fi
+
+FAILED=0
+# checks the program at $1:
+function check_program () {
+	$EXE < $1 > $WORK_DIR/compiled.out
+	COMPILE_RES=$?
+	$EXE --ast < $1 > $WORK_DIR/lowered.out
+	AST_RES=$?
+	$EXE --check-only < $1 > $WORK_DIR/checked.out
+	CHECK_RES=$?
+	if [ $COMPILE_RES -ne $AST_RES ] || ! cmp -s $WORK_DIR/compiled.out $WORK_DIR/lowered.out; then
+		printf "$1 (--ast): ${RED} FAILURE ${NC}\n"
+		diff $WORK_DIR/compiled.out $WORK_DIR/lowered.out | head
+		FAILED=1
+		return
+	fi
+	if [ $COMPILE_RES -eq 0 ]; then
+		# the code is not printed, so there should be no output at all:
+		: > $WORK_DIR/compiled.out
+	fi
+	if [ $COMPILE_RES -ne $CHECK_RES ] || ! cmp -s $WORK_DIR/compiled.out $WORK_DIR/checked.out; then
+		printf "$1 (--check-only): ${RED} FAILURE ${NC}\n"
+		diff $WORK_DIR/compiled.out $WORK_DIR/checked.out
+		FAILED=1
+		return
+	fi
+	printf "$1: ${GREEN} SUCCESS ${NC}\n"
+}
+
+TESTS_DIRS=${@:-errors alex yosnkos}
+for TESTS_DIR in $TESTS_DIRS
+do
+	for TEST in $(ls $TESTS_DIR/t*.in | sort -V)
+	do
+		check_program $TEST
+	done
+done
+exit $FAILED
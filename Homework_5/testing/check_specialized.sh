@@ -0,0 +1,40 @@
+# compiles every program of the tests directory with 'hw5 --specialize', and compares the specialized copies of the functions
+# (with their constants folded) to the expected ones. the program should also print the same as it does without '--specialize'.
+# usage: ./check_specialized.sh [tests directory] [path to hw5]   (default: specialized ../hw5)
+TESTS_DIR=${1:-'specialized'}
+EXE=${2:-'../hw5'}
+WORK_DIR=$(mktemp -d)
+trap "rm -rf $WORK_DIR" EXIT
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+if [ ! -f $EXE ]; then
+	printf "${RED}Error: executable: '${EXE}'  -  not found! ${NC}\n"
+	exit 1
+fi
+
+FAILED=0
+for TEST in $(ls $TESTS_DIR/t*.in | sort -V)
+do
+	EXPECTED=${TEST%.in}.exp
+	$EXE --specialize < $TEST > $WORK_DIR/specialized.ll
+	sed -n '/^define .*\.spec[0-9]*(/,/^}/p' $WORK_DIR/specialized.ll > $WORK_DIR/copies.ll
+	if ! diff $EXPECTED $WORK_DIR/copies.ll; then
+		printf "$TEST: ${RED} FAILURE ${NC}\n"
+		printf "\t${BLUE}< expected but not found${NC}\n"
+		printf "\t${BLUE}> found but not expected${NC}\n"
+		FAILED=1
+		continue
+	fi
+	$EXE < $TEST > $WORK_DIR/program.ll
+	if ! cmp -s <(lli $WORK_DIR/program.ll) <(lli $WORK_DIR/specialized.ll); then
+		printf "$TEST (output): ${RED} FAILURE ${NC}\n"
+		FAILED=1
+		continue
+	fi
+	printf "$TEST: ${GREEN} SUCCESS ${NC}\n"
+done
+exit $FAILED
@@ -0,0 +1,70 @@
+//measures the throughput of a FanC scanner - built once with lex.yy.c and once with handlexer.cpp by 'make bench-lexers'.
+//usage: lex_bench [megabytes of generated input] [number of threads]
+#include "Symtab.hpp"
+#include "parser.tab.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+using namespace std;
+
+YYSTYPE yylval;
+bool scanInputFile(const char* path);
+bool lexInParallel(int num_threads);
+int yylex();
+
+//the scanners call it before a lexical error, which the generated input does not have:
+void reportEarlierErrors(){}
+
+//writes about 'size' bytes of valid FanC code, with the usual mix of identifiers, numbers, strings and comments.
+static void writeInput(const char* path, size_t size){
+	FILE* file = fopen(path, "w");
+	size_t written = 0;
+	for(int func = 0; written < size; ++func){
+		string code = "// computes the values of function number " + to_string(func) + "\n"
+			"int func" + to_string(func) + "(int count, byte step, bool verbose){\n"
+			"\tint total = 0;\n"
+			"\twhile(count >= 0 and total != 123456){\n"
+			"\t\tif(verbose or not (count < 17)){\n"
+			"\t\t\tprint(\"the current total is a bit too large\");\n"
+			"\t\t} else {\n"
+			"\t\t\ttotal = total + count * 3 - (step / 2b); // the step is a byte\n"
+			"\t\t}\n"
+			"\t\tcount = count - 1;\n"
+			"\t}\n"
+			"\treturn total;\n"
+			"}\n\n";
+		fputs(code.c_str(), file);
+		written += code.size();
+	}
+	fclose(file);
+}
+
+int main(int argc, char* argv[]){
+	size_t megabytes = argc > 1 ? atoi(argv[1]) : 64;
+	int num_threads = argc > 2 ? atoi(argv[2]) : 1;
+	const char* path = "lex_bench_input.fanc";
+	writeInput(path, megabytes << 20);
+
+	auto start = chrono::steady_clock::now();
+	if(!scanInputFile(path)){
+		fprintf(stderr, "can not read %s\n", path);
+		return 1;
+	}
+	if(num_threads > 1 && !lexInParallel(num_threads))
+		printf("the input is scanned by a single thread\n");
+	long long num_tokens = 0;
+	while(yylex() != 0)
+		++num_tokens;
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	remove(path);
+
+#ifdef HAND_LEXER
+	const char* scanner = "hand written";
+#else
+	const char* scanner = "flex";
+#endif
+	printf("%s scanner, %d thread(s): %lld tokens, %zu MB in %.3f seconds: %.1f MB/s\n"
+		, scanner, num_threads, num_tokens, megabytes, seconds, megabytes / seconds);
+	return 0;
+}
@@ -0,0 +1,69 @@
+# compiles and runs generated programs of many functions, and of deeply nested blocks and expressions.
+# usage: ./scale.sh [numbers of functions...]   (default: 100000 1000000)
+EXE='../hw5'
+WORK_DIR=$(mktemp -d)
+trap "rm -rf $WORK_DIR" EXIT
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+if [ ! -f $EXE ]; then
+	printf "${RED}Error: executable: '${EXE}'  -  not found! ${NC}\n"
+	exit 1
+fi
+
+FAILED=0
+# runs the program at $1 compiled with the flags $4, whose output should be $2:
+function check_program () {
+	START=$(date +%s%N)
+	$EXE $4 < $1 > $WORK_DIR/program.ll
+	COMPILE_RES=$?
+	END=$(date +%s%N)
+	RES=$(lli $WORK_DIR/program.ll)
+	if [ $COMPILE_RES -eq 0 ] && [ "$RES" == "$2" ]; then
+		printf "$3: ${GREEN} SUCCESS ${NC} (compiled in $(( (END - START) / 1000000 )) ms)\n"
+	else
+		printf "$3: ${RED} FAILURE ${NC} (expected '$2', got '$RES')\n"
+		FAILED=1
+	fi
+}
+
+NUMS_OF_FUNCS=${@:-100000 1000000}
+for N in $NUMS_OF_FUNCS
+do
+	# every function calls the one before it, so none of them is removed as unreachable:
+	awk -v n=$N 'BEGIN{
+		print "int f0(int x, int y){ return x + y; }"
+		for(i = 1; i < n; ++i)
+			printf "int f%d(int x, int y){ if(x > 0) return f%d(x - 1, y + 1); return y; }\n", i, i - 1
+		printf "void main(){ printi(f%d(0, %d)); printi(f%d(3, 0)); }\n", n - 1, n, n - 1
+	}' > $WORK_DIR/funcs.in
+	check_program $WORK_DIR/funcs.in "$(printf "$N\n3")" "$N functions"
+done
+
+DEPTH=100000
+awk -v depth=$DEPTH 'BEGIN{
+	printf "void main(){ int x = 1; "
+	for(i = 0; i < depth; ++i) printf "{"
+	printf "x = x + 1;"
+	for(i = 0; i < depth; ++i) printf "}"
+	printf " printi("
+	for(i = 0; i < depth; ++i) printf "("
+	printf "x"
+	for(i = 0; i < depth; ++i) printf ")"
+	print "); }"
+}' > $WORK_DIR/nested.in
+check_program $WORK_DIR/nested.in "2" "$DEPTH nested blocks and parentheses"
+check_program $WORK_DIR/nested.in "2" "$DEPTH nested blocks and parentheses with --ast" --ast
+
+# checking the same program should report no errors:
+$EXE --check-only < $WORK_DIR/nested.in > $WORK_DIR/checked.out
+if [ $? -eq 0 ] && [ ! -s $WORK_DIR/checked.out ]; then
+	printf "$DEPTH nested blocks and parentheses with --check-only: ${GREEN} SUCCESS ${NC}\n"
+else
+	printf "$DEPTH nested blocks and parentheses with --check-only: ${RED} FAILURE ${NC}\n"
+	FAILED=1
+fi
+
+exit $FAILED
@@ -0,0 +1,57 @@
+# runs every program of a tests directory with 'hw5 --vm', and with 'hw5 | lli', checks that both print the same,
+# and compares the time each takes from the source to the end of the run.
+# usage: ./vm_bench.sh [path to hw5] [tests directory]   (default: ../hw5 alex)
+EXE=${1:-'../hw5'}
+TESTS_DIR=${2:-'alex'}
+WORK_DIR=$(mktemp -d)
+trap "rm -rf $WORK_DIR" EXIT
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+if [ ! -f $EXE ]; then
+	printf "${RED}Error: executable: '${EXE}'  -  not found! ${NC}\n"
+	exit 1
+fi
+
+FAILED=0
+LLI_TOTAL=0
+VM_TOTAL=0
+# runs the program at $1 both ways, and adds the times to the totals:
+function bench_program () {
+	START=$(date +%s%N)
+	$EXE < $1 > $WORK_DIR/program.ll
+	lli $WORK_DIR/program.ll > $WORK_DIR/lli.out
+	MIDDLE=$(date +%s%N)
+	$EXE --vm < $1 > $WORK_DIR/vm.out
+	END=$(date +%s%N)
+	LLI_US=$(( (MIDDLE - START) / 1000 ))
+	VM_US=$(( (END - MIDDLE) / 1000 ))
+	LLI_TOTAL=$(( LLI_TOTAL + LLI_US ))
+	VM_TOTAL=$(( VM_TOTAL + VM_US ))
+	if cmp -s $WORK_DIR/lli.out $WORK_DIR/vm.out; then
+		printf "$2: ${GREEN} SAME ${NC} (lli $LLI_US us, vm $VM_US us)\n"
+	else
+		printf "$2: ${RED} DIFFERENT ${NC}\n"
+		FAILED=1
+	fi
+}
+
+for TEST in $(ls $TESTS_DIR/t*.in | sort -V)
+do
+	bench_program $TEST $TEST
+done
+printf "$TESTS_DIR: lli $(( LLI_TOTAL / 1000 )) ms, vm $(( VM_TOTAL / 1000 )) ms in total\n"
+
+# a program that spends its time running rather than starting, where lli's compiled code is expected to win:
+awk 'BEGIN{
+	print "int fib(int k){ if(k < 2) return k; return fib(k - 1) + fib(k - 2); }"
+	print "int collatz(int start){ int n = start; int steps = 0;"
+	print "	while(n != 1){ if(n - (n / 2) * 2 == 0) n = n / 2; else n = 3 * n + 1; steps = steps + 1; }"
+	print "	return steps; }"
+	print "void main(){ printi(fib(27)); int i = 1; int total = 0;"
+	print "	while(i < 100000){ total = total + collatz(i); i = i + 1; } printi(total); }"
+}' > $WORK_DIR/loops.in
+bench_program $WORK_DIR/loops.in "fib and collatz loops"
+exit $FAILED
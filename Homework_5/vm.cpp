@@ -0,0 +1,1232 @@
+//the bytecode backend of the code buffer, used by 'hw5 --vm'. it does not need llvm at all: the finished buffers are
+//compiled to a compact register based bytecode, which is run right away by the interpreter at the end of this file,
+//with the same results as running the printed module with lli (bytes wrap around, a division by zero prints the same
+//error and exits with 1, and printi/print format their arguments like printf).
+#include "bp.hpp"
+#include "IrText.hpp"
+#include "assert.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <algorithm>
+#include <memory>
+using namespace std;
+
+namespace{
+
+/**
+ * the instructions and their operands. every operand is a 32 bit word: 'd', 'a' and 'b' are registers of the current frame,
+ * 'imm' is an immediate and 't' is the address of an instruction in the code.
+ * the registers are 64 bit, and always hold the value of their llvm type extended to 64 bits: i32 and i64 values are
+ * sign extended, and i8 and i1 values are zero extended, so comparing them never needs the type.
+ * 		MOV d a / LOADI d imm / LOADI64 d low high
+ * 		ADD..AND d a b - i32 arithmetic, its result is wrapped around to 32 bits.
+ * 		ADDI..ASHRI d a imm - the same, with a constant second operand.
+ * 		ADD64..AND64 d a b - i64 arithmetic.
+ * 		SEXT8 d a / SEXT32 d a / ZEXT32 d a - the casts that change the value of a register.
+ * 		CMP_<cc> d a b - an icmp, 0 or 1.
+ * 		J_<cc> a b t / JI_<cc> a imm t - jumps to 't' if the comparison holds, these replace an icmp and the br that uses it.
+ * 		JMP t
+ * 		SWITCH a n default (case t)*n - the cases are sorted, and binary searched.
+ * 		TABLE a min n default t*n - a switch with dense cases, 't' is jumped to for 'a == min + <its index>'.
+ * 		LOAD d a imm / STORE a b imm / STOREI imm b imm2 - access the word at the address 'b + imm' (or 'a + imm' for LOAD).
+ * 		ALLOCA d n - 'd' gets the address of n new words on the stack of the current call.
+ * 		CALL func frame d argc a*argc - the frame of the callee starts 'frame' registers after the current one, and
+ * 			its parameters are its first registers. 'd' is -1 for a void function.
+ * 		RET a / RETI imm / RETV
+ * 		PRINTI a / PRINTS string / ERRZ a - the library functions.
+ */
+#define VM_OPCODES(X) \
+	X(MOV) X(LOADI) X(LOADI64) \
+	X(ADD) X(SUB) X(MUL) X(SDIV) X(UDIV) X(SHL) X(LSHR) X(ASHR) X(AND) \
+	X(ADDI) X(MULI) X(ANDI) X(SHLI) X(LSHRI) X(ASHRI) \
+	X(ADD64) X(SUB64) X(MUL64) X(SDIV64) X(UDIV64) X(SHL64) X(LSHR64) X(ASHR64) X(AND64) \
+	X(SEXT8) X(SEXT32) X(ZEXT32) \
+	X(CMP_EQ) X(CMP_NE) X(CMP_SLT) X(CMP_SLE) X(CMP_SGT) X(CMP_SGE) X(CMP_ULT) X(CMP_ULE) X(CMP_UGT) X(CMP_UGE) \
+	X(J_EQ) X(J_NE) X(J_SLT) X(J_SLE) X(J_SGT) X(J_SGE) X(J_ULT) X(J_ULE) X(J_UGT) X(J_UGE) \
+	X(JI_EQ) X(JI_NE) X(JI_SLT) X(JI_SLE) X(JI_SGT) X(JI_SGE) X(JI_ULT) X(JI_ULE) X(JI_UGT) X(JI_UGE) \
+	X(JMP) X(SWITCH) X(TABLE) \
+	X(LOAD) X(STORE) X(STOREI) X(ALLOCA) \
+	X(CALL) X(RET) X(RETI) X(RETV) \
+	X(PRINTI) X(PRINTS) X(ERRZ)
+
+enum Opcode{
+#define VM_OPCODE_ENUM(name) OP_##name,
+	VM_OPCODES(VM_OPCODE_ENUM)
+#undef VM_OPCODE_ENUM
+};
+
+//the comparisons, in the order of the CMP_/J_/JI_ opcodes. the unsigned ones compare the low 32 bits:
+#define VM_CONDITIONS(X) \
+	X(EQ, ==, int64_t) X(NE, !=, int64_t) X(SLT, <, int64_t) X(SLE, <=, int64_t) X(SGT, >, int64_t) X(SGE, >=, int64_t) \
+	X(ULT, <, uint32_t) X(ULE, <=, uint32_t) X(UGT, >, uint32_t) X(UGE, >=, uint32_t)
+
+enum Condition{
+#define VM_CONDITION_ENUM(name, op, type) CC_##name,
+	VM_CONDITIONS(VM_CONDITION_ENUM)
+#undef VM_CONDITION_ENUM
+};
+
+Condition condition(string_view relop){
+	static const unordered_map<string_view, Condition> conditions = {
+		{"eq", CC_EQ}, {"ne", CC_NE}, {"slt", CC_SLT}, {"sle", CC_SLE}, {"sgt", CC_SGT}, {"sge", CC_SGE},
+		{"ult", CC_ULT}, {"ule", CC_ULE}, {"ugt", CC_UGT}, {"uge", CC_UGE}};
+	return conditions.at(relop);
+}
+
+//the condition that holds exactly when 'cc' does not:
+Condition negated(Condition cc){
+	static const Condition negations[] = {CC_NE, CC_EQ, CC_SGE, CC_SGT, CC_SLE, CC_SLT, CC_UGE, CC_UGT, CC_ULE, CC_ULT};
+	return negations[cc];
+}
+
+//the condition that holds for (b, a) exactly when 'cc' holds for (a, b):
+Condition swapped(Condition cc){
+	static const Condition swaps[] = {CC_EQ, CC_NE, CC_SGT, CC_SGE, CC_SLT, CC_SLE, CC_UGT, CC_UGE, CC_ULT, CC_ULE};
+	return swaps[cc];
+}
+
+bool holds(Condition cc, int64_t a, int64_t b){
+	switch(cc){
+#define VM_CONDITION_CASE(name, op, type) case CC_##name: return (type)a op (type)b;
+	VM_CONDITIONS(VM_CONDITION_CASE)
+#undef VM_CONDITION_CASE
+	}
+	return false;
+}
+
+int64_t wrap32(int64_t value){
+	return (int32_t)(uint32_t)value;
+}
+
+//the value of 'value' as an llvm value of 'bits' bits, extended the way the registers hold it:
+int64_t normalize(int64_t value, int bits){
+	switch(bits){
+	case 1:
+		return value & 1;
+	case 8:
+		return value & 0xFF;
+	case 32:
+		return wrap32(value);
+	}
+	return value;
+}
+
+bool fitsInt32(int64_t value){
+	return value == (int32_t)value;
+}
+
+//a type of the code buffer, 'dims' are the sizes of its arrays from the outside in, e.g [4096 x [1 x i32]] is {4096, 1}:
+struct IrType{
+	vector<int64_t> dims;
+	int bits = 0;//0 for void.
+
+	//the number of words of the memory that a value of this type takes, every scalar takes a whole word:
+	int64_t words(size_t first_dim = 0) const{
+		int64_t result = 1;
+		for(size_t i = first_dim; i < dims.size(); ++i)
+			result *= dims[i];
+		return result;
+	}
+};
+
+IrType readType(Cursor& cursor){
+	IrType type;
+	while(cursor.peek() == '['){
+		cursor.expect('[');
+		type.dims.push_back(toInt(cursor.word()));
+		cursor.word();//'x'
+	}
+	string_view name = cursor.word();
+	if(name != "void")
+		type.bits = toInt(name.substr(1));
+	for(size_t i = 0; i < type.dims.size(); ++i)
+		cursor.expect(']');
+	//the memory is not typed, so a pointer is just a number of a word:
+	while(cursor.pos < cursor.text.size() && cursor.text[cursor.pos] == '*')
+		++cursor.pos;
+	return type;
+}
+
+struct VmFunction{
+	int entry = -1;
+	int num_regs = 0;
+};
+
+struct VmProgram{
+	vector<int32_t> code;
+	vector<VmFunction> funcs;
+	unordered_map<string, int> func_ids;
+	vector<string> strings;
+	//the memo tables are at the start of the memory, and the stack starts right after them:
+	int64_t globals_words = 0;
+};
+
+const int NO_REG = -1;
+
+//an operand of a command, a register or a constant:
+struct Operand{
+	bool is_const;
+	int64_t value;
+	int reg;
+
+	static Operand constant(int64_t value){
+		return {true, value, NO_REG};
+	}
+	static Operand inReg(int reg){
+		return {false, 0, reg};
+	}
+};
+
+//a pointer that is known to be a register (NO_REG for none) plus a constant number of words:
+struct Address{
+	int reg;
+	int64_t offset;
+};
+
+/**
+ * @brief compiles the functions of the code buffer one by one into a VmProgram.
+ * 		most of the copies that the code buffer emits ('add i32 0, %reg', casts that do not change the value) get no
+ * 		instruction at all, and neither do the pointers to the stack variables, which are folded into the loads and stores.
+ */
+class BytecodeCompiler{
+public:
+	BytecodeCompiler(VmProgram& program, int num_names)
+		:program(program), names(num_names), labels(num_names), uses(num_names){}
+
+	//'definition' is a memo table, like '@.memo_valid_f = internal global [4096 x i1] zeroinitializer'.
+	void addGlobal(const string& definition);
+	void addString(const string& id, const string& value);
+	void addCommands(const string& commands);
+	int funcIndex(const string& id);
+private:
+	VmProgram& program;
+	vector<int32_t>& code = program.code;
+	unordered_map<string, int64_t> global_addresses;
+	unordered_map<string, int> string_indices;
+
+	//what each register of the code buffer is in the current function. like labels, a name can be used in more than one
+	//function (a specialized copy uses the names of the original), so a slot is valid only if 'func' is the current one.
+	enum NameKind{
+		IN_REG,
+		CONSTANT,
+		ADDRESS
+	};
+	struct NameSlot{
+		int func = -1;
+		NameKind kind;
+		//a name that is used before its definition gets a register, which the definition has to write to:
+		bool defined;
+		int reg;//the register, or the base register of an ADDRESS.
+		int64_t value;//the constant, or the offset of an ADDRESS.
+	};
+	struct LabelSlot{
+		int func = -1;
+		int address;
+		//the lines of the phis at the start of the block:
+		vector<size_t> phis;
+	};
+	struct UseCount{
+		int func = -1;
+		int count;
+	};
+	vector<NameSlot> names;
+	vector<LabelSlot> labels;
+	vector<UseCount> uses;
+	int func_count = 0;
+
+	//the lines of the function that is read, from its 'define' line up to its '}':
+	vector<string_view> lines;
+	int current_func;
+	int num_regs;
+	int current_label;
+	bool terminated;
+	//the instructions that jump to a label that was not placed yet, and the CALLs that need the size of the frame:
+	vector<pair<size_t, int>> label_fixups;
+	vector<size_t> frame_fixups;
+	//a jump from a block to a block with phis goes through an edge, which sets the phis and then jumps to the block:
+	struct Edge{
+		int from_label;
+		int to_label;
+		vector<size_t> fixups;
+	};
+	vector<Edge> edges;
+
+	void compileFunction();
+	void beginFunction(string_view command);
+	//compiles the command at 'index', and returns the index of the last command it compiled:
+	size_t compileCommand(size_t index);
+	void defineLabel(int label);
+	void compileBinop(int result_name, string_view op, Cursor& cursor);
+	void compileCast(int result_name, string_view op, Cursor& cursor);
+	void compileGetElementPtr(int result_name, Cursor& cursor);
+	void compileSwitch(Cursor& cursor, int next_label);
+	void compileCall(int result_name, Cursor& cursor);
+
+	void emit(initializer_list<int64_t> words);
+	int newReg(){
+		return num_regs++;
+	}
+	NameSlot& slot(int name);
+	int nameReg(int name);
+	//the register that the instruction that defines 'name' should write to:
+	int resultReg(int name);
+	//defines 'name' without an instruction if possible:
+	void defineAs(int name, Operand value);
+	void defineAddress(int name, Address address);
+	Operand readOperand(Cursor& cursor);
+	Address readAddress(Cursor& cursor);
+	int toReg(Operand operand);
+	void moveTo(int reg, Operand value);
+	//moves all of the values at once, like the phis of a block:
+	void parallelMove(const vector<pair<int, Operand>>& moves);
+
+	bool hasPhis(int label){
+		return labels[label].func == func_count && !labels[label].phis.empty();
+	}
+	void emitTarget(int label);
+	void emitPhiMoves(int from_label, int to_label);
+	//jumps to 'label', with no instruction at all if it is 'next_label':
+	void emitJump(int label, int next_label);
+	void emitBranch(Condition cc, Operand first, Operand second, int true_label, int false_label, int next_label);
+	int labelAt(size_t index) const;
+};
+
+int BytecodeCompiler::funcIndex(const string& id){
+	auto it = program.func_ids.find(id);
+	if(it != program.func_ids.end())
+		return it->second;
+	program.funcs.emplace_back();
+	program.func_ids[id] = program.funcs.size() - 1;
+	return program.funcs.size() - 1;
+}
+
+void BytecodeCompiler::addGlobal(const string& definition){
+	Cursor cursor{definition};
+	string id(cursor.word().substr(1));
+	bool is_memo_table = cursor.eat("= internal global");
+	assert(is_memo_table);
+	global_addresses[id] = program.globals_words;
+	program.globals_words += readType(cursor).words();
+}
+
+void BytecodeCompiler::addString(const string& id, const string& value){
+	string_indices[id.substr(1)] = program.strings.size();
+	program.strings.push_back(unescape(value));
+}
+
+void BytecodeCompiler::addCommands(const string& commands){
+	forEachLine(commands, [this](string_view command){
+		if(command.empty())
+			return;
+		if(command.compare(0, 7, "define ") == 0)
+			lines.clear();
+		lines.push_back(command);
+		if(command == "}")
+			compileFunction();
+	});
+}
+
+void BytecodeCompiler::emit(initializer_list<int64_t> words){
+	for(int64_t word: words){
+		assert(fitsInt32(word));
+		code.push_back(word);
+	}
+}
+
+BytecodeCompiler::NameSlot& BytecodeCompiler::slot(int name){
+	NameSlot& name_slot = names[name];
+	if(name_slot.func != func_count)
+		name_slot = {.func = func_count, .kind = IN_REG, .defined = false, .reg = newReg(), .value = 0};
+	return name_slot;
+}
+
+int BytecodeCompiler::nameReg(int name){
+	NameSlot& name_slot = slot(name);
+	switch(name_slot.kind){
+	case IN_REG:
+		return name_slot.reg;
+	case CONSTANT:
+		return toReg(Operand::constant(name_slot.value));
+	case ADDRESS:
+		break;
+	}
+	int reg = newReg();
+	if(name_slot.reg == NO_REG)
+		emit({OP_LOADI, reg, name_slot.value});
+	else
+		emit({OP_ADDI, reg, name_slot.reg, name_slot.value});
+	return reg;
+}
+
+int BytecodeCompiler::resultReg(int name){
+	bool used_before = names[name].func == func_count;
+	NameSlot& name_slot = slot(name);
+	assert(!used_before || (name_slot.kind == IN_REG && !name_slot.defined));
+	name_slot.defined = true;
+	return name_slot.reg;
+}
+
+void BytecodeCompiler::defineAs(int name, Operand value){
+	if(names[name].func == func_count){
+		moveTo(resultReg(name), value);
+		return;
+	}
+	if(value.is_const)
+		names[name] = {.func = func_count, .kind = CONSTANT, .defined = true, .reg = NO_REG, .value = value.value};
+	else
+		names[name] = {.func = func_count, .kind = IN_REG, .defined = true, .reg = value.reg, .value = 0};
+}
+
+void BytecodeCompiler::defineAddress(int name, Address address){
+	if(names[name].func == func_count){
+		int reg = resultReg(name);
+		if(address.reg == NO_REG)
+			emit({OP_LOADI, reg, address.offset});
+		else
+			emit({OP_ADDI, reg, address.reg, address.offset});
+		return;
+	}
+	names[name] = {.func = func_count, .kind = ADDRESS, .defined = true, .reg = address.reg, .value = address.offset};
+}
+
+Operand BytecodeCompiler::readOperand(Cursor& cursor){
+	string_view word = cursor.word();
+	switch(word[0]){
+	case '$':{
+		NameSlot& name_slot = slot(toInt(word.substr(1)));
+		if(name_slot.kind == CONSTANT)
+			return Operand::constant(name_slot.value);
+		return Operand::inReg(nameReg(toInt(word.substr(1))));
+	}
+	case '%':
+		//the parameters are the unnamed registers, and the first registers of the frame:
+		return Operand::inReg(toInt(word.substr(1)));
+	case '@':
+		return Operand::constant(global_addresses.at(string(word.substr(1))));
+	}
+	if(word == "getelementptr"){
+		//a pointer to the first char of a string constant, 'getelementptr ([n x i8], [n x i8]* @id, i32 0, i32 0)'.
+		//the strings are not in the memory, such a pointer is the index of the string:
+		cursor.expect('(');
+		readType(cursor);
+		readType(cursor);
+		string id(cursor.word().substr(1));
+		while(cursor.peek() != ')')
+			cursor.word();
+		cursor.expect(')');
+		return Operand::constant(string_indices.at(id));
+	}
+	return Operand::constant(toInt(word));
+}
+
+Address BytecodeCompiler::readAddress(Cursor& cursor){
+	string_view word = cursor.word();
+	if(word[0] == '@')
+		return {NO_REG, global_addresses.at(string(word.substr(1)))};
+	assert(word[0] == '$');
+	int name = toInt(word.substr(1));
+	NameSlot& name_slot = slot(name);
+	if(name_slot.kind == ADDRESS)
+		return {name_slot.reg, name_slot.value};
+	return {nameReg(name), 0};
+}
+
+int BytecodeCompiler::toReg(Operand operand){
+	if(!operand.is_const)
+		return operand.reg;
+	int reg = newReg();
+	moveTo(reg, operand);
+	return reg;
+}
+
+void BytecodeCompiler::moveTo(int reg, Operand value){
+	if(!value.is_const){
+		if(value.reg != reg)
+			emit({OP_MOV, reg, value.reg});
+	} else if(fitsInt32(value.value)){
+		emit({OP_LOADI, reg, value.value});
+	} else {
+		emit({OP_LOADI64, reg, (int32_t)(uint32_t)value.value, (int32_t)(value.value >> 32)});
+	}
+}
+
+void BytecodeCompiler::parallelMove(const vector<pair<int, Operand>>& moves){
+	bool overlap = false;
+	for(const pair<int, Operand>& move: moves){
+		for(const pair<int, Operand>& other: moves)
+			overlap = overlap || (&move != &other && !other.second.is_const && other.second.reg == move.first);
+	}
+	if(!overlap){
+		for(const pair<int, Operand>& move: moves)
+			moveTo(move.first, move.second);
+		return;
+	}
+	vector<int> temps;
+	for(const pair<int, Operand>& move: moves){
+		temps.push_back(newReg());
+		moveTo(temps.back(), move.second);
+	}
+	for(size_t i = 0; i < moves.size(); ++i)
+		moveTo(moves[i].first, Operand::inReg(temps[i]));
+}
+
+void BytecodeCompiler::emitPhiMoves(int from_label, int to_label){
+	vector<pair<int, Operand>> moves;
+	for(size_t phi_line: labels[to_label].phis){
+		//'$<name> = phi <type> [<value>, $<label>], ...':
+		Cursor cursor{lines[phi_line]};
+		int name = toInt(cursor.word().substr(1));
+		cursor.word();//'='
+		cursor.word();//'phi'
+		readType(cursor);
+		bool found = false;
+		while(!cursor.atEnd() && !found){
+			cursor.expect('[');
+			size_t value_pos = cursor.pos;
+			cursor.word();
+			found = (toInt(cursor.word().substr(1)) == from_label);
+			cursor.expect(']');
+			if(found){
+				Cursor value_cursor{lines[phi_line], value_pos};
+				moves.push_back({nameReg(name), readOperand(value_cursor)});
+			}
+		}
+		assert(found);
+	}
+	parallelMove(moves);
+}
+
+void BytecodeCompiler::emitTarget(int label){
+	if(hasPhis(label)){
+		auto it = find_if(edges.begin(), edges.end(), [&](const Edge& edge){
+			return edge.from_label == current_label && edge.to_label == label;
+		});
+		if(it == edges.end()){
+			edges.push_back({current_label, label, {}});
+			it = edges.end() - 1;
+		}
+		it->fixups.push_back(code.size());
+	} else {
+		label_fixups.push_back({code.size(), label});
+	}
+	code.push_back(-1);
+}
+
+void BytecodeCompiler::emitJump(int label, int next_label){
+	if(hasPhis(label))
+		emitPhiMoves(current_label, label);
+	if(label != next_label){
+		code.push_back(OP_JMP);
+		label_fixups.push_back({code.size(), label});
+		code.push_back(-1);
+	}
+	terminated = true;
+}
+
+void BytecodeCompiler::emitBranch(Condition cc, Operand first, Operand second, int true_label, int false_label
+	, int next_label){
+	if(first.is_const && second.is_const){
+		emitJump(holds(cc, first.value, second.value) ? true_label : false_label, next_label);
+		return;
+	}
+	if(first.is_const){
+		swap(first, second);
+		cc = swapped(cc);
+	}
+	if(true_label == next_label && !hasPhis(true_label)){
+		swap(true_label, false_label);
+		cc = negated(cc);
+	}
+	if(second.is_const && fitsInt32(second.value))
+		emit({OP_JI_EQ + cc, first.reg, second.value});
+	else
+		emit({OP_J_EQ + cc, first.reg, toReg(second)});
+	emitTarget(true_label);
+	emitJump(false_label, next_label);
+}
+
+int BytecodeCompiler::labelAt(size_t index) const{
+	string_view line = lines[index];
+	if(line[0] == '$' && line.back() == ':')
+		return toInt(line.substr(1, line.size() - 2));
+	return -1;
+}
+
+void BytecodeCompiler::beginFunction(string_view command){
+	//'define <return type>@<id>(i32, i32, ...){':
+	size_t at = command.find('@');
+	size_t params_begin = command.find('(', at);
+	int num_params = 0;
+	if(command[params_begin + 1] != ')')
+		num_params = count(command.begin() + params_begin, command.end(), ',') + 1;
+	current_func = funcIndex(string(command.substr(at + 1, params_begin - at - 1)));
+	program.funcs[current_func].entry = code.size();
+	num_regs = num_params;
+	current_label = -1;
+	terminated = false;
+	label_fixups.clear();
+	frame_fixups.clear();
+	edges.clear();
+	++func_count;
+}
+
+void BytecodeCompiler::compileFunction(){
+	beginFunction(lines.front());
+	//the uses of every register, and the phis of every block:
+	int label = -1;
+	for(size_t i = 1; i + 1 < lines.size(); ++i){
+		string_view line = lines[i];
+		if(labelAt(i) != -1){
+			label = labelAt(i);
+			labels[label] = {.func = func_count, .address = -1, .phis = {}};
+			continue;
+		}
+		//a definition is at the start of the line, and is not a use:
+		for(size_t pos = line.find('$', 1); pos != string_view::npos; pos = line.find('$', pos + 1)){
+			size_t end = pos + 1;
+			while(end < line.size() && isdigit(line[end]))
+				++end;
+			UseCount& use = uses[toInt(line.substr(pos + 1, end - pos - 1))];
+			if(use.func != func_count)
+				use = {func_count, 0};
+			++use.count;
+		}
+		if(line.find(" = phi ") != string_view::npos){
+			assert(label != -1);
+			labels[label].phis.push_back(i);
+		}
+	}
+
+	for(size_t i = 1; i + 1 < lines.size(); ++i)
+		i = compileCommand(i);
+
+	//the edges are placed after the code of the function:
+	for(Edge& edge: edges){
+		int address = code.size();
+		for(size_t fixup: edge.fixups)
+			code[fixup] = address;
+		current_label = edge.from_label;
+		emitJump(edge.to_label, -1);
+	}
+	for(const pair<size_t, int>& fixup: label_fixups){
+		assert(labels[fixup.second].func == func_count && labels[fixup.second].address != -1);
+		code[fixup.first] = labels[fixup.second].address;
+	}
+	for(size_t fixup: frame_fixups)
+		code[fixup] = num_regs;
+	program.funcs[current_func].num_regs = num_regs;
+	lines.clear();
+}
+
+void BytecodeCompiler::defineLabel(int label){
+	//a block that is not terminated falls through to this one:
+	if(!terminated && hasPhis(label))
+		emitPhiMoves(current_label, label);
+	labels[label].address = code.size();
+	current_label = label;
+	terminated = false;
+}
+
+size_t BytecodeCompiler::compileCommand(size_t index){
+	string_view command = lines[index];
+	if(labelAt(index) != -1){
+		defineLabel(labelAt(index));
+		return index;
+	}
+	//the code after a terminator and before the next label can not be reached:
+	if(terminated)
+		return index;
+	int next_label = index + 1 < lines.size() ? labelAt(index + 1) : -1;
+
+	Cursor cursor{command};
+	int result_name = -1;
+	if(command[0] == '$'){
+		size_t assignment = command.find(" = ");
+		result_name = toInt(command.substr(1, assignment - 1));
+		cursor.pos = assignment + 3;
+	}
+	string_view op = cursor.word();
+	if(op == "alloca"){
+		emit({OP_ALLOCA, resultReg(result_name), readType(cursor).words()});
+	} else if(op == "getelementptr"){
+		compileGetElementPtr(result_name, cursor);
+	} else if(op == "load"){
+		readType(cursor);
+		readType(cursor);
+		Address address = readAddress(cursor);
+		if(address.reg == NO_REG){
+			address.reg = toReg(Operand::constant(address.offset));
+			address.offset = 0;
+		}
+		emit({OP_LOAD, resultReg(result_name), address.reg, address.offset});
+	} else if(op == "store"){
+		readType(cursor);
+		Operand value = readOperand(cursor);
+		readType(cursor);
+		Address address = readAddress(cursor);
+		if(address.reg == NO_REG){
+			address.reg = toReg(Operand::constant(address.offset));
+			address.offset = 0;
+		}
+		if(value.is_const && fitsInt32(value.value))
+			emit({OP_STOREI, value.value, address.reg, address.offset});
+		else
+			emit({OP_STORE, toReg(value), address.reg, address.offset});
+	} else if(op == "icmp"){
+		Condition cc = condition(cursor.word());
+		IrType type = readType(cursor);
+		Operand first = readOperand(cursor);
+		Operand second = readOperand(cursor);
+		assert(type.bits != 1 || cc == CC_EQ || cc == CC_NE);
+		assert(type.bits != 64 || cc < CC_ULT);
+		if(type.bits == 8 && cc >= CC_SLT && cc <= CC_SGE){
+			//the bytes are zero extended in the registers:
+			for(Operand* operand: {&first, &second}){
+				if(operand->is_const){
+					operand->value = (int8_t)operand->value;
+				} else {
+					int reg = newReg();
+					emit({OP_SEXT8, reg, operand->reg});
+					*operand = Operand::inReg(reg);
+				}
+			}
+		}
+		//an icmp that is only used by the branch right after it is compiled together with the branch:
+		const string branch_prefix = "br i1 " + CodeBuffer::nameRef(result_name) + ",";
+		if(uses[result_name].func == func_count && uses[result_name].count == 1 && index + 1 < lines.size()
+			&& lines[index + 1].compare(0, branch_prefix.size(), branch_prefix) == 0){
+			Cursor branch{lines[index + 1], branch_prefix.size()};
+			branch.word();//'label'
+			int true_label = toInt(branch.word().substr(1));
+			branch.word();//'label'
+			int false_label = toInt(branch.word().substr(1));
+			emitBranch(cc, first, second, true_label, false_label, index + 2 < lines.size() ? labelAt(index + 2) : -1);
+			return index + 1;
+		}
+		if(first.is_const && second.is_const){
+			defineAs(result_name, Operand::constant(holds(cc, first.value, second.value)));
+		} else {
+			if(first.is_const){
+				swap(first, second);
+				cc = swapped(cc);
+			}
+			int second_reg = toReg(second);
+			emit({OP_CMP_EQ + cc, resultReg(result_name), first.reg, second_reg});
+		}
+	} else if(op == "zext" || op == "sext" || op == "trunc"){
+		compileCast(result_name, op, cursor);
+	} else if(op == "br"){
+		if(cursor.eat("label")){
+			emitJump(toInt(cursor.word().substr(1)), next_label);
+		} else {
+			readType(cursor);
+			Operand cond = readOperand(cursor);
+			cursor.word();//'label'
+			int true_label = toInt(cursor.word().substr(1));
+			cursor.word();//'label'
+			int false_label = toInt(cursor.word().substr(1));
+			emitBranch(CC_NE, cond, Operand::constant(0), true_label, false_label, next_label);
+		}
+	} else if(op == "switch"){
+		compileSwitch(cursor, next_label);
+	} else if(op == "phi"){
+		//set by the blocks that jump to this one:
+		resultReg(result_name);
+	} else if(op == "call"){
+		compileCall(result_name, cursor);
+	} else if(op == "ret"){
+		IrType type = readType(cursor);
+		if(type.bits == 0){
+			emit({OP_RETV});
+		} else {
+			Operand value = readOperand(cursor);
+			if(value.is_const && fitsInt32(value.value))
+				emit({OP_RETI, value.value});
+			else
+				emit({OP_RET, toReg(value)});
+		}
+		terminated = true;
+	} else {
+		compileBinop(result_name, op, cursor);
+	}
+	return index;
+}
+
+void BytecodeCompiler::compileBinop(int result_name, string_view op, Cursor& cursor){
+	static const unordered_map<string_view, Opcode> ops = {
+		{"add", OP_ADD}, {"sub", OP_SUB}, {"mul", OP_MUL}, {"sdiv", OP_SDIV}, {"udiv", OP_UDIV},
+		{"shl", OP_SHL}, {"lshr", OP_LSHR}, {"ashr", OP_ASHR}, {"and", OP_AND}};
+	Opcode opcode = ops.at(op);
+	int bits = readType(cursor).bits;
+	Operand first = readOperand(cursor);
+	Operand second = readOperand(cursor);
+	bool commutative = (opcode == OP_ADD || opcode == OP_MUL || opcode == OP_AND);
+	if(first.is_const && second.is_const && !((opcode == OP_SDIV || opcode == OP_UDIV) && second.value == 0)){
+		int64_t a = first.value;
+		int64_t b = second.value;
+		//the registers hold the values extended, so only the unsigned operations have to look at the type:
+		uint64_t mask = (bits == 64 ? ~0ULL : (1ULL << bits) - 1);
+		int64_t result = 0;
+		switch(opcode){
+		case OP_ADD: result = (uint64_t)a + (uint64_t)b; break;
+		case OP_SUB: result = (uint64_t)a - (uint64_t)b; break;
+		case OP_MUL: result = (uint64_t)a * (uint64_t)b; break;
+		case OP_SDIV: result = (b == -1 ? -(uint64_t)a : a / b); break;
+		case OP_UDIV: result = ((uint64_t)a & mask) / ((uint64_t)b & mask); break;
+		case OP_SHL: result = (uint64_t)a << (b & 63); break;
+		case OP_LSHR: result = ((uint64_t)a & mask) >> (b & 63); break;
+		case OP_ASHR: result = a >> (b & 63); break;
+		case OP_AND: result = a & b; break;
+		default: break;
+		}
+		defineAs(result_name, Operand::constant(normalize(result, bits)));
+		return;
+	}
+	if(opcode == OP_ADD && first.is_const && first.value == 0){
+		//the way the code buffer copies a value:
+		defineAs(result_name, second);
+		return;
+	}
+	if(first.is_const && commutative)
+		swap(first, second);
+	int first_reg = toReg(first);
+	int result_reg;
+	if(bits == 64){
+		int second_reg = toReg(second);
+		result_reg = resultReg(result_name);
+		emit({OP_ADD64 + (opcode - OP_ADD), result_reg, first_reg, second_reg});
+		return;
+	}
+	static const unordered_map<int, Opcode> immediate_ops = {
+		{OP_ADD, OP_ADDI}, {OP_MUL, OP_MULI}, {OP_AND, OP_ANDI}, {OP_SHL, OP_SHLI}, {OP_LSHR, OP_LSHRI}, {OP_ASHR, OP_ASHRI}};
+	if(opcode == OP_SUB && second.is_const){
+		opcode = OP_ADD;
+		second.value = -second.value;
+	}
+	//the bytes and the booleans are zero extended, which the 32 bit operations keep, except for the sign:
+	assert(bits == 32 || (opcode != OP_SDIV && opcode != OP_ASHR));
+	if(second.is_const && fitsInt32(second.value) && immediate_ops.count(opcode) == 1){
+		result_reg = resultReg(result_name);
+		emit({immediate_ops.at(opcode), result_reg, first_reg, second.value});
+	} else {
+		int second_reg = toReg(second);
+		result_reg = resultReg(result_name);
+		emit({opcode, result_reg, first_reg, second_reg});
+	}
+	if(bits < 32 && opcode != OP_AND && opcode != OP_LSHR && opcode != OP_UDIV)
+		emit({OP_ANDI, result_reg, result_reg, (1 << bits) - 1});
+}
+
+void BytecodeCompiler::compileCast(int result_name, string_view op, Cursor& cursor){
+	int from_bits = readType(cursor).bits;
+	Operand value = readOperand(cursor);
+	cursor.word();//'to'
+	int to_bits = readType(cursor).bits;
+	if(value.is_const){
+		int64_t result = value.value;
+		if(op == "sext" && from_bits == 8)
+			result = (int8_t)result;
+		else if(op == "zext" && from_bits == 32)
+			result = (uint32_t)result;
+		defineAs(result_name, Operand::constant(normalize(result, to_bits)));
+	} else if(op == "trunc"){
+		if(to_bits == 32)
+			emit({OP_SEXT32, resultReg(result_name), value.reg});
+		else
+			emit({OP_ANDI, resultReg(result_name), value.reg, (1 << to_bits) - 1});
+	} else if(op == "sext" && from_bits == 8){
+		emit({OP_SEXT8, resultReg(result_name), value.reg});
+	} else if(op == "zext" && from_bits == 32){
+		emit({OP_ZEXT32, resultReg(result_name), value.reg});
+	} else {
+		//a zext of a byte or a boolean, or a sext of a 32 bit value, are already extended that way:
+		assert(op == "zext" || from_bits == 32);
+		defineAs(result_name, value);
+	}
+}
+
+void BytecodeCompiler::compileGetElementPtr(int result_name, Cursor& cursor){
+	//'getelementptr <type>, <type>* <pointer>, <index type> <index>, ...', every index steps over the elements
+	//of one more level of the type:
+	IrType type = readType(cursor);
+	readType(cursor);
+	Address address = readAddress(cursor);
+	int index_reg = NO_REG;
+	for(size_t level = 0; !cursor.atEnd(); ++level){
+		readType(cursor);
+		Operand index = readOperand(cursor);
+		int64_t stride = type.words(level);
+		if(index.is_const){
+			address.offset += index.value * stride;
+			continue;
+		}
+		int scaled_reg = index.reg;
+		if(stride != 1){
+			scaled_reg = newReg();
+			emit({OP_MULI, scaled_reg, index.reg, stride});
+		}
+		if(index_reg != NO_REG){
+			int sum_reg = newReg();
+			emit({OP_ADD, sum_reg, index_reg, scaled_reg});
+			scaled_reg = sum_reg;
+		}
+		index_reg = scaled_reg;
+	}
+	if(index_reg == NO_REG){
+		defineAddress(result_name, address);
+		return;
+	}
+	if(address.reg != NO_REG){
+		int sum_reg = newReg();
+		emit({OP_ADD, sum_reg, address.reg, index_reg});
+		index_reg = sum_reg;
+	}
+	emit({OP_ADDI, resultReg(result_name), index_reg, address.offset});
+}
+
+void BytecodeCompiler::compileSwitch(Cursor& cursor, int next_label){
+	//'switch <type> <value>, label <default> [ <type> <constant>, label <label> ... ]':
+	readType(cursor);
+	Operand value = readOperand(cursor);
+	cursor.word();//'label'
+	int default_label = toInt(cursor.word().substr(1));
+	vector<pair<int64_t, int>> cases;
+	cursor.expect('[');
+	while(cursor.peek() != ']'){
+		readType(cursor);
+		int64_t constant = readOperand(cursor).value;
+		cursor.word();//'label'
+		cases.push_back({constant, (int)toInt(cursor.word().substr(1))});
+	}
+	if(value.is_const){
+		auto it = find_if(cases.begin(), cases.end(), [&](const pair<int64_t, int>& c){ return c.first == value.value; });
+		emitJump(it == cases.end() ? default_label : it->second, next_label);
+		return;
+	}
+	sort(cases.begin(), cases.end());
+	int64_t min = cases.front().first;
+	int64_t range = cases.back().first - min + 1;
+	if(range <= 2 * (int64_t)cases.size() + 4){
+		emit({OP_TABLE, value.reg, min, range});
+		emitTarget(default_label);
+		size_t next_case = 0;
+		for(int64_t constant = min; constant < min + range; ++constant){
+			if(cases[next_case].first == constant)
+				emitTarget(cases[next_case++].second);
+			else
+				emitTarget(default_label);
+		}
+	} else {
+		emit({OP_SWITCH, value.reg, (int64_t)cases.size()});
+		emitTarget(default_label);
+		for(const pair<int64_t, int>& c: cases){
+			emit({c.first});
+			emitTarget(c.second);
+		}
+	}
+	terminated = true;
+}
+
+void BytecodeCompiler::compileCall(int result_name, Cursor& cursor){
+	//'call <return type>(<param types>) @<id>(<type> <value>, ...)':
+	readType(cursor);
+	cursor.expect('(');
+	while(cursor.peek() != ')')
+		readType(cursor);
+	cursor.expect(')');
+	string id(cursor.word().substr(1));
+	vector<Operand> args;
+	cursor.expect('(');
+	while(cursor.peek() != ')'){
+		readType(cursor);
+		args.push_back(readOperand(cursor));
+	}
+	cursor.expect(')');
+	if(id == "print"){
+		assert(args[0].is_const);
+		emit({OP_PRINTS, args[0].value});
+	} else if(id == "printi"){
+		emit({OP_PRINTI, toReg(args[0])});
+	} else if(id == "errorIfZero9001"){
+		if(!args[0].is_const || args[0].value == 0)
+			emit({OP_ERRZ, toReg(args[0])});
+	} else {
+		vector<int64_t> arg_regs;
+		for(const Operand& arg: args)
+			arg_regs.push_back(toReg(arg));
+		int result_reg = (result_name == -1 ? -1 : resultReg(result_name));
+		emit({OP_CALL, funcIndex(id)});
+		frame_fixups.push_back(code.size());
+		emit({-1, result_reg, (int64_t)arg_regs.size()});
+		for(int64_t arg_reg: arg_regs)
+			emit({arg_reg});
+	}
+}
+
+//the output of the program, written in large chunks:
+class Output{
+public:
+	~Output(){
+		flush();
+	}
+	void printInt(int32_t value){
+		char digits[16];
+		char* end = digits + sizeof(digits);
+		char* begin = end;
+		*--begin = '\n';
+		uint32_t magnitude = (value < 0 ? -(uint32_t)value : value);
+		do{
+			*--begin = '0' + magnitude % 10;
+			magnitude /= 10;
+		} while(magnitude != 0);
+		if(value < 0)
+			*--begin = '-';
+		write(begin, end - begin);
+	}
+	void printLine(const string& str){
+		//printf("%s\n") stops at the first null char:
+		write(str.c_str(), strlen(str.c_str()));
+		write("\n", 1);
+	}
+	void flush(){
+		fwrite(buffer, 1, size, stdout);
+		fflush(stdout);
+		size = 0;
+	}
+private:
+	static const size_t CAPACITY = 1 << 16;
+	char buffer[CAPACITY];
+	size_t size = 0;
+
+	void write(const char* chars, size_t count){
+		if(size + count > CAPACITY){
+			flush();
+			if(count > CAPACITY){
+				fwrite(chars, 1, count, stdout);
+				return;
+			}
+		}
+		memcpy(buffer + size, chars, count);
+		size += count;
+	}
+};
+
+//the error of a division by zero is printed by the program, like the library function does:
+[[noreturn]] void exitDivisionByZero(Output& output){
+	output.printLine("Error division by zero");
+	output.flush();
+	exit(1);
+}
+
+//where a native program would crash, the interpreter stops with an error of its own:
+[[noreturn]] void exitStackOverflow(Output& output){
+	output.flush();
+	fprintf(stderr, "hw5: the program ran out of stack\n");
+	exit(1);
+}
+
+/**
+ * @brief runs 'func' (which has no parameters) until it returns.
+ * 		the instructions are dispatched with computed gotos (a gcc extension), each one jumps straight to the next.
+ */
+void run(const VmProgram& program, int func){
+	//the limits of a program that recurses too deep, well beyond what the default stack of lli allows:
+	static const size_t MAX_REGS = 1 << 24;
+	static const size_t MAX_CALL_DEPTH = 1 << 20;
+	static const size_t MEMORY_WORDS = 1 << 24;
+	struct Frame{
+		const int32_t* return_pc;
+		int64_t* regs;
+		int result_reg;
+		int64_t stack_top;
+	};
+	//left uninitialized, so only the pages that are used are ever touched:
+	unique_ptr<int64_t[]> regs_storage(new int64_t[MAX_REGS]);
+	unique_ptr<Frame[]> frames(new Frame[MAX_CALL_DEPTH]);
+	unique_ptr<int32_t[]> memory_storage(new int32_t[MEMORY_WORDS]);
+	unique_ptr<Output> output(new Output());
+	assert(program.globals_words < (int64_t)MEMORY_WORDS);
+	memset(memory_storage.get(), 0, program.globals_words * sizeof(int32_t));
+
+	static const void* const handlers[] = {
+#define VM_HANDLER_ADDRESS(name) &&L_##name,
+		VM_OPCODES(VM_HANDLER_ADDRESS)
+#undef VM_HANDLER_ADDRESS
+	};
+	const int32_t* const code = program.code.data();
+	const VmFunction* const funcs = program.funcs.data();
+	int32_t* const memory = memory_storage.get();
+	const int64_t* const regs_end = regs_storage.get() + MAX_REGS;
+	Frame* frame = frames.get();
+	Frame* const last_frame = frames.get() + MAX_CALL_DEPTH - 1;
+	int64_t* r = regs_storage.get();
+	int64_t stack_top = program.globals_words;
+	int64_t return_value;
+	const int32_t* pc = code + funcs[func].entry;
+	frame->return_pc = nullptr;
+
+#define DISPATCH() goto *handlers[*pc]
+#define NEXT(size) pc += size; DISPATCH()
+#define ARITHMETIC_HANDLER(name, expression) L_##name:{ \
+		int64_t a = r[pc[2]]; int64_t b = r[pc[3]]; r[pc[1]] = (expression); NEXT(4); }
+#define IMMEDIATE_HANDLER(name, expression) L_##name:{ \
+		int64_t a = r[pc[2]]; int64_t b = pc[3]; r[pc[1]] = (expression); NEXT(4); }
+#define CONDITION_HANDLERS(name, op, type) \
+	L_CMP_##name: r[pc[1]] = ((type)r[pc[2]] op (type)r[pc[3]]); NEXT(4); \
+	L_J_##name: if((type)r[pc[1]] op (type)r[pc[2]]){ pc = code + pc[3]; DISPATCH(); } NEXT(4); \
+	L_JI_##name: if((type)r[pc[1]] op (type)(int64_t)pc[2]){ pc = code + pc[3]; DISPATCH(); } NEXT(4);
+
+	DISPATCH();
+L_MOV:
+	r[pc[1]] = r[pc[2]];
+	NEXT(3);
+L_LOADI:
+	r[pc[1]] = pc[2];
+	NEXT(3);
+L_LOADI64:
+	r[pc[1]] = (int64_t)(((uint64_t)(uint32_t)pc[3] << 32) | (uint32_t)pc[2]);
+	NEXT(4);
+	ARITHMETIC_HANDLER(ADD, wrap32(a + b))
+	ARITHMETIC_HANDLER(SUB, wrap32(a - b))
+	ARITHMETIC_HANDLER(MUL, wrap32((uint64_t)a * (uint64_t)b))
+	ARITHMETIC_HANDLER(SDIV, wrap32(a / b))
+	ARITHMETIC_HANDLER(UDIV, wrap32((uint32_t)a / (uint32_t)b))
+	ARITHMETIC_HANDLER(SHL, wrap32((uint32_t)a << (b & 31)))
+	ARITHMETIC_HANDLER(LSHR, wrap32((uint32_t)a >> (b & 31)))
+	ARITHMETIC_HANDLER(ASHR, a >> (b & 31))
+	ARITHMETIC_HANDLER(AND, a & b)
+	IMMEDIATE_HANDLER(ADDI, wrap32(a + b))
+	IMMEDIATE_HANDLER(MULI, wrap32((uint64_t)a * (uint64_t)b))
+	IMMEDIATE_HANDLER(ANDI, a & b)
+	IMMEDIATE_HANDLER(SHLI, wrap32((uint32_t)a << (b & 31)))
+	IMMEDIATE_HANDLER(LSHRI, wrap32((uint32_t)a >> (b & 31)))
+	IMMEDIATE_HANDLER(ASHRI, a >> (b & 31))
+	ARITHMETIC_HANDLER(ADD64, (uint64_t)a + (uint64_t)b)
+	ARITHMETIC_HANDLER(SUB64, (uint64_t)a - (uint64_t)b)
+	ARITHMETIC_HANDLER(MUL64, (uint64_t)a * (uint64_t)b)
+	ARITHMETIC_HANDLER(SDIV64, b == -1 ? -(uint64_t)a : a / b)
+	ARITHMETIC_HANDLER(UDIV64, (uint64_t)a / (uint64_t)b)
+	ARITHMETIC_HANDLER(SHL64, (uint64_t)a << (b & 63))
+	ARITHMETIC_HANDLER(LSHR64, (uint64_t)a >> (b & 63))
+	ARITHMETIC_HANDLER(ASHR64, a >> (b & 63))
+	ARITHMETIC_HANDLER(AND64, a & b)
+L_SEXT8:
+	r[pc[1]] = (int8_t)r[pc[2]];
+	NEXT(3);
+L_SEXT32:
+	r[pc[1]] = wrap32(r[pc[2]]);
+	NEXT(3);
+L_ZEXT32:
+	r[pc[1]] = (uint32_t)r[pc[2]];
+	NEXT(3);
+	VM_CONDITIONS(CONDITION_HANDLERS)
+L_JMP:
+	pc = code + pc[1];
+	DISPATCH();
+L_SWITCH:{
+	int64_t value = r[pc[1]];
+	int32_t num_cases = pc[2];
+	const int32_t* cases = pc + 4;
+	int32_t low = 0;
+	int32_t high = num_cases;
+	while(low < high){
+		int32_t middle = (low + high) / 2;
+		if(cases[2 * middle] < value)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	pc = code + (low < num_cases && cases[2 * low] == value ? cases[2 * low + 1] : pc[3]);
+	DISPATCH();
+}
+L_TABLE:{
+	uint64_t index = r[pc[1]] - pc[2];
+	pc = code + (index < (uint32_t)pc[3] ? pc[5 + index] : pc[4]);
+	DISPATCH();
+}
+L_LOAD:
+	r[pc[1]] = memory[r[pc[2]] + pc[3]];
+	NEXT(4);
+L_STORE:
+	memory[r[pc[2]] + pc[3]] = r[pc[1]];
+	NEXT(4);
+L_STOREI:
+	memory[r[pc[2]] + pc[3]] = pc[1];
+	NEXT(4);
+L_ALLOCA:
+	r[pc[1]] = stack_top;
+	stack_top += pc[2];
+	if(stack_top > (int64_t)MEMORY_WORDS)
+		exitStackOverflow(*output);
+	NEXT(3);
+L_CALL:{
+	const VmFunction& callee = funcs[pc[1]];
+	int64_t* callee_regs = r + pc[2];
+	if(frame == last_frame || callee_regs + callee.num_regs > regs_end)
+		exitStackOverflow(*output);
+	int32_t num_args = pc[4];
+	for(int32_t i = 0; i < num_args; ++i)
+		callee_regs[i] = r[pc[5 + i]];
+	++frame;
+	*frame = {pc + 5 + num_args, r, pc[3], stack_top};
+	r = callee_regs;
+	pc = code + callee.entry;
+	DISPATCH();
+}
+L_RET:
+	return_value = r[pc[1]];
+	goto do_return;
+L_RETI:
+	return_value = pc[1];
+	goto do_return;
+L_RETV:
+	return_value = 0;
+do_return:
+	if(!frame->return_pc)
+		return;
+	pc = frame->return_pc;
+	r = frame->regs;
+	stack_top = frame->stack_top;
+	if(frame->result_reg != -1)
+		r[frame->result_reg] = return_value;
+	--frame;
+	DISPATCH();
+L_PRINTI:
+	output->printInt(r[pc[1]]);
+	NEXT(2);
+L_PRINTS:
+	output->printLine(program.strings[pc[1]]);
+	NEXT(2);
+L_ERRZ:
+	if(r[pc[1]] == 0)
+		exitDivisionByZero(*output);
+	NEXT(2);
+
+#undef CONDITION_HANDLERS
+#undef IMMEDIATE_HANDLER
+#undef ARITHMETIC_HANDLER
+#undef NEXT
+#undef DISPATCH
+}
+
+}
+
+void CodeBuffer::runBytecode(){
+	VmProgram program;
+	BytecodeCompiler compiler(program, name_hints.size());
+	//without the library functions, the global buffer only holds the memo tables:
+	for(const string& definition: globalDefs)
+		compiler.addGlobal(definition);
+	for(const pair<const string, string>& string_id: string_ids){
+		if(!reachability_known || reachable_strings.count(string_id.second) == 1)
+			compiler.addString(string_id.second, string_id.first);
+	}
+	for(const string& commands: buffer)
+		compiler.addCommands(commands);
+	int main_func = compiler.funcIndex("main");
+	assert(program.funcs[main_func].entry != -1);
+	run(program, main_func);
+}